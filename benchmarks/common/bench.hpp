@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///Sink for results, prevents optimizer to remove measured code
+inline volatile std::size_t bench_sink = 0;
+
+///Measure function and print time per operation
+/**
+@param name name of the measurement
+@param ops count of operations performed by the function
+@param fn function to measure. It can return a value, which is passed to the sink
+ */
+template<typename Fn>
+void benchmark(std::string_view name, std::size_t ops, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    if constexpr(std::is_void_v<decltype(fn())>) {
+        fn();
+    } else {
+        bench_sink = bench_sink + static_cast<std::size_t>(fn());
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << std::left << std::setw(56) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << ns / static_cast<double>(ops) << " ns/op" << std::endl;
+}
+
+///Measure function and print throughput
+/**
+@param name name of the measurement
+@param bytes count of bytes processed by the function
+@param fn function to measure. It can return a value, which is passed to the sink
+ */
+template<typename Fn>
+void benchmark_throughput(std::string_view name, std::size_t bytes, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    if constexpr(std::is_void_v<decltype(fn())>) {
+        fn();
+    } else {
+        bench_sink = bench_sink + static_cast<std::size_t>(fn());
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(stop - start).count();
+    std::cout << std::left << std::setw(56) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << static_cast<double>(bytes) / sec / 1e6 << " MB/s" << std::endl;
+}
+
+///Generate random integer keys
+inline std::vector<std::size_t> random_int_keys(std::size_t count, unsigned int seed = 1) {
+    std::mt19937_64 rnd(seed);
+    std::vector<std::size_t> out(count);
+    for (auto &x: out) x = static_cast<std::size_t>(rnd());
+    return out;
+}
+
+///Generate random string keys
+/**
+@param count count of keys
+@param length length of each key (minimal length is 16 characters)
+@param seed random seed
+ */
+inline std::vector<std::string> random_string_keys(std::size_t count, std::size_t length = 16, unsigned int seed = 1) {
+    std::mt19937_64 rnd(seed);
+    std::vector<std::string> out(count);
+    for (auto &x: out) {
+        x.resize(length);
+        for (auto &c: x) c = static_cast<char>('a' + rnd() % 26);
+    }
+    return out;
+}
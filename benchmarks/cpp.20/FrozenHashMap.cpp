@@ -0,0 +1,41 @@
+#include <cpp.20/FrozenHashMap.hpp>
+#include <cpp.20/OpenHashMap.hpp>
+#include "../common/bench.hpp"
+
+constexpr std::size_t table_size = 1000;
+constexpr std::size_t lookups = 10000000;
+
+constexpr std::array<std::pair<std::size_t, std::size_t>, table_size> generate_items() {
+    std::array<std::pair<std::size_t, std::size_t>, table_size> out = {};
+    for (std::size_t i = 0; i < table_size; ++i) out[i] = {i * 2654435761ULL, i};
+    return out;
+}
+
+constexpr FrozenHashMap frozen(generate_items());
+
+int main() {
+    OpenHashMap<std::size_t, std::size_t> open;
+    for (const auto &[k, v]: generate_items()) open.emplace(k, v);
+    std::vector<std::size_t> keys(lookups);
+    std::mt19937 rnd(1);
+    //half of keys are missing
+    for (auto &k: keys) k = (rnd() % (table_size * 2)) * 2654435761ULL;
+
+    benchmark("FrozenHashMap find", lookups, [&]{
+        std::size_t sum = 0;
+        for (auto k: keys) {
+            auto iter = frozen.find(k);
+            if (iter != frozen.end()) sum += iter->second;
+        }
+        return sum;
+    });
+    benchmark("OpenHashMap find", lookups, [&]{
+        std::size_t sum = 0;
+        for (auto k: keys) {
+            auto iter = open.find(k);
+            if (iter != open.end()) sum += iter->second;
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <cpp.20/OpenHashMap.hpp>
+#include "../common/bench.hpp"
+#include <utility>
+
+constexpr std::size_t count = 1000000;
+
+template<typename Map, typename Keys>
+void bench_map(std::string_view name, const Keys &keys, const Keys &missing) {
+    std::string prefix(name);
+    Map map;
+    benchmark(prefix + " insert", keys.size(), [&]{
+        for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+        return map.size();
+    });
+    benchmark(prefix + " find (hit)", keys.size(), [&]{
+        std::size_t sum = 0;
+        for (const auto &k: keys) sum += map.find(k)->second;
+        return sum;
+    });
+    benchmark(prefix + " find (miss)", missing.size(), [&]{
+        std::size_t cnt = 0;
+        for (const auto &k: missing) cnt += map.find(k) == map.end();
+        return cnt;
+    });
+    benchmark(prefix + " erase", keys.size(), [&]{
+        for (const auto &k: keys) map.erase(k);
+        return map.size();
+    });
+}
+
+///measure the worst latency of single insertion
+template<typename Map, typename Keys>
+void bench_insert_latency(std::string_view name, const Keys &keys) {
+    Map map;
+    double worst = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        map.emplace(keys[i], i);
+        auto stop = std::chrono::steady_clock::now();
+        worst = std::max(worst, std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+    std::cout << std::left << std::setw(56) << (std::string(name) + " worst insert")
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+              << worst << " us" << std::endl;
+}
+
+///compare find() and find_many() on table, which doesn't fit into cache
+template<typename Map>
+void bench_find_many(std::string_view name, std::size_t count) {
+    std::string prefix(name);
+    auto keys = random_int_keys(count, 5);
+    auto lookup = random_int_keys(count, 6);
+    Map map;
+    for (std::size_t i = 0; i < count; ++i) map.emplace(keys[i], i);
+    //half of lookups hit, in random order
+    for (std::size_t i = 0; i < count; i+=2) lookup[i] = keys[lookup[i+1] % count];
+    benchmark(prefix + " find", lookup.size(), [&]{
+        std::size_t cnt = 0;
+        for (const auto &k: lookup) cnt += map.find(k) != map.end();
+        return cnt;
+    });
+    std::vector<typename Map::const_iterator> res(lookup.size(), map.end());
+    benchmark(prefix + " find_many", lookup.size(), [&]{
+        std::as_const(map).find_many(lookup, res.begin());
+        std::size_t cnt = 0;
+        for (const auto &r: res) cnt += r != map.end();
+        return cnt;
+    });
+    std::vector<char> flags(lookup.size());
+    benchmark(prefix + " contains_many", lookup.size(), [&]{
+        map.contains_many(lookup, flags.begin());
+        std::size_t cnt = 0;
+        for (auto r: flags) cnt += r;
+        return cnt;
+    });
+}
+
+///value of 200 bytes
+struct LargeValue {
+    std::size_t data[25];
+    LargeValue(std::size_t v) {for (auto &x: data) x = v;}
+    operator std::size_t() const {return data[0];}
+};
+
+///lookups in a map with large values
+template<typename Map>
+void bench_large_values(std::string_view name, const std::vector<std::size_t> &keys, const std::vector<std::size_t> &missing) {
+    std::string prefix(name);
+    Map map;
+    for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+    benchmark(prefix + " find (hit)", keys.size(), [&]{
+        std::size_t sum = 0;
+        for (const auto &k: keys) sum += map.find(k)->second;
+        return sum;
+    });
+    benchmark(prefix + " find (miss)", missing.size(), [&]{
+        std::size_t cnt = 0;
+        for (const auto &k: missing) cnt += map.find(k) == map.end();
+        return cnt;
+    });
+}
+
+///bulk load of known count of keys, with and without reserve()
+template<typename Map, typename Keys>
+void bench_bulk_load(std::string_view name, const Keys &keys) {
+    std::string prefix(name);
+    benchmark(prefix + " bulk load", keys.size(), [&]{
+        Map map;
+        for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+        return map.size();
+    });
+    benchmark(prefix + " bulk load, reserve", keys.size(), [&]{
+        Map map;
+        map.reserve(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+        return map.size();
+    });
+}
+
+///many short-lived small maps
+template<typename Map, typename Keys>
+void bench_small_maps(std::string_view name, const Keys &keys, std::size_t items) {
+    std::string prefix(name);
+    benchmark(prefix + " small maps (" + std::to_string(items) + " items)", keys.size(), [&]{
+        std::size_t found = 0;
+        for (std::size_t i = 0; i + items <= keys.size(); i += items) {
+            Map map;
+            for (std::size_t j = 0; j < items; ++j) map.emplace(keys[i + j], j);
+            found += map.find(keys[i])->second;
+        }
+        return found;
+    });
+}
+
+int main() {
+    auto int_keys = random_int_keys(count, 1);
+    auto int_missing = random_int_keys(count, 2);
+    auto str_keys = random_string_keys(count, 16, 1);
+    auto str_missing = random_string_keys(count, 16, 2);
+
+    using K = std::size_t;
+    using S = std::string;
+
+    bench_map<OpenHashMap<K, std::size_t> >("int, PrimeCapacity", int_keys, int_missing);
+    bench_map<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, PowerOfTwoCapacity> >("int, PowerOfTwoCapacity", int_keys, int_missing);
+    bench_map<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, PowerOfTwoCapacity, RobinHoodProbing> >("int, PowerOfTwoCapacity, RobinHood", int_keys, int_missing);
+    bench_map<OpenHashMap<S, std::size_t> >("string, PrimeCapacity", str_keys, str_missing);
+    bench_map<OpenHashMap<S, std::size_t, std::hash<S>, std::equal_to<S>, PowerOfTwoCapacity> >("string, PowerOfTwoCapacity", str_keys, str_missing);
+    bench_map<OpenHashMap<S, std::size_t, std::hash<S>, std::equal_to<S>, PowerOfTwoCapacity, RobinHoodProbing> >("string, PowerOfTwoCapacity, RobinHood", str_keys, str_missing);
+
+    auto long_keys = random_string_keys(count / 4, 256, 3);
+    auto long_missing = random_string_keys(count / 4, 256, 4);
+    bench_map<OpenHashMap<S, std::size_t> >("string(256)", long_keys, long_missing);
+    bench_map<OpenHashMap<S, std::size_t, std::hash<S>, std::equal_to<S>, StoreHash> >("string(256), StoreHash", long_keys, long_missing);
+    bench_map<OpenHashMap<S, std::size_t, std::hash<S>, std::equal_to<S>, PowerOfTwoCapacity, RobinHoodProbing, StoreHash> >("string(256), PowerOfTwo, RobinHood, StoreHash", long_keys, long_missing);
+
+    bench_large_values<OpenHashMap<K, LargeValue> >("int->200B", int_keys, int_missing);
+    bench_large_values<OpenHashMap<K, LargeValue, std::hash<K>, std::equal_to<K>, SplitKeyValue> >("int->200B, SplitKeyValue", int_keys, int_missing);
+
+    bench_find_many<OpenHashMap<K, std::size_t> >("int, 16M", count * 16);
+    bench_find_many<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, PowerOfTwoCapacity> >("int, 16M, PowerOfTwoCapacity", count * 16);
+
+    bench_bulk_load<OpenHashMap<K, std::size_t> >("int", int_keys);
+    bench_bulk_load<OpenHashMap<S, std::size_t> >("string", str_keys);
+
+    bench_small_maps<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, PowerOfTwoCapacity> >("int", int_keys, 8);
+    bench_small_maps<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, PowerOfTwoCapacity, InlineStorage<16> > >("int, InlineStorage<16>", int_keys, 8);
+
+    bench_insert_latency<OpenHashMap<K, std::size_t> >("int", int_keys);
+    bench_insert_latency<OpenHashMap<K, std::size_t, std::hash<K>, std::equal_to<K>, IncrementalRehash<> > >("int, IncrementalRehash", int_keys);
+    bench_insert_latency<OpenHashMap<S, std::size_t> >("string", str_keys);
+    bench_insert_latency<OpenHashMap<S, std::size_t, std::hash<S>, std::equal_to<S>, IncrementalRehash<> > >("string, IncrementalRehash", str_keys);
+    return 0;
+}
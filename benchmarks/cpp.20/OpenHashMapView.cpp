@@ -0,0 +1,50 @@
+#include <cpp.20/OpenHashMapView.hpp>
+#include <cpp.20/MappedFile.hpp>
+#include "../common/bench.hpp"
+#include <filesystem>
+#include <fstream>
+
+constexpr std::size_t count = 4000000;
+
+int main() {
+    using Map = OpenHashMap<std::size_t, std::size_t>;
+    using View = OpenHashMapView<std::size_t, std::size_t>;
+    auto keys = random_int_keys(count, 1);
+    Map map;
+    for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+    auto path = std::filesystem::temp_directory_path() / "bench_open_hash_map_view.bin";
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        benchmark("write image", count, [&]{
+            View::write(map, [&](std::span<const std::byte> data) {
+                f.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            });
+        });
+    }
+    benchmark("load by insertion", count, [&]{
+        Map m;
+        for (std::size_t i = 0; i < keys.size(); ++i) m.emplace(keys[i], i);
+        return m.size();
+    });
+    benchmark("load by mapping", count, [&]{
+        MappedFile file(path);
+        View view(file.bytes());
+        return view.size();
+    });
+    {
+        MappedFile file(path);
+        View view(file.bytes());
+        benchmark("find in mapped view", count, [&]{
+            std::size_t sum = 0;
+            for (auto k: keys) sum += view.find(k)->second;
+            return sum;
+        });
+        benchmark("find in map", count, [&]{
+            std::size_t sum = 0;
+            for (auto k: keys) sum += map.find(k)->second;
+            return sum;
+        });
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <cpp.20/OrderedHashMap.hpp>
+#include "../common/bench.hpp"
+
+constexpr std::size_t count = 1000000;
+
+///iteration of map, where most of items were erased
+template<typename Map>
+void bench_sparse_iteration(std::string_view name, const std::vector<std::size_t> &keys) {
+    std::string prefix(name);
+    Map map;
+    for (std::size_t i = 0; i < keys.size(); ++i) map.emplace(keys[i], i);
+    benchmark(prefix + " find (hit)", keys.size(), [&]{
+        std::size_t sum = 0;
+        for (const auto &k: keys) sum += map.find(k)->second;
+        return sum;
+    });
+    benchmark(prefix + " iterate (full)", keys.size(), [&]{
+        std::size_t sum = 0;
+        for (const auto &[k, v]: map) sum += v;
+        return sum;
+    });
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (i % 10) {
+            if constexpr(requires {map.swap_erase(keys[i]);}) map.swap_erase(keys[i]);
+            else map.erase(keys[i]);
+        }
+    }
+    benchmark(prefix + " iterate (10% left)", map.size(), [&]{
+        std::size_t sum = 0;
+        for (const auto &[k, v]: map) sum += v;
+        return sum;
+    });
+}
+
+int main() {
+    auto keys = random_int_keys(count, 1);
+    bench_sparse_iteration<OpenHashMap<std::size_t, std::size_t> >("OpenHashMap", keys);
+    bench_sparse_iteration<OrderedHashMap<std::size_t, std::size_t> >("OrderedHashMap", keys);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cpp.20/ShardedHashMap.hpp>
+#include "../common/bench.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+constexpr std::size_t count = 1000000;
+constexpr std::size_t ops_per_thread = 2000000;
+
+///OpenHashMap protected by single mutex, for comparison
+class LockedMap {
+public:
+    template<typename Key, typename Fn>
+    bool visit(const Key &key, Fn &&fn) const {
+        std::lock_guard _(_lock);
+        auto iter = _map.find(key);
+        if (iter == _map.end()) return false;
+        fn(iter->second);
+        return true;
+    }
+    bool insert_or_assign(std::size_t key, std::size_t val) {
+        std::lock_guard _(_lock);
+        auto r = _map.try_emplace(key, val);
+        if (!r.second) r.first->second = val;
+        return r.second;
+    }
+protected:
+    mutable std::mutex _lock;
+    OpenHashMap<std::size_t, std::size_t> _map;
+};
+
+///Run mix of reads and writes on all threads
+/**
+@param write_percent percent of operations, which are writes
+ */
+template<typename Map>
+void bench_mix(std::string_view name, Map &map, const std::vector<std::size_t> &keys, unsigned int threads, unsigned int write_percent) {
+    for (std::size_t i = 0; i < keys.size(); ++i) map.insert_or_assign(keys[i], i);
+    std::string title = std::string(name) + ", " + std::to_string(threads) + " threads, "
+                      + std::to_string(write_percent) + "% writes";
+    benchmark(title, ops_per_thread * threads, [&]{
+        std::vector<std::thread> workers;
+        std::atomic<std::size_t> total = 0;
+        for (unsigned int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]{
+                std::mt19937_64 rnd(t);
+                std::size_t sum = 0;
+                for (std::size_t i = 0; i < ops_per_thread; ++i) {
+                    auto r = rnd();
+                    const auto &k = keys[r % keys.size()];
+                    if ((r >> 32) % 100 < write_percent) {
+                        map.insert_or_assign(k, i);
+                    } else {
+                        map.visit(k, [&](std::size_t v) {sum += v;});
+                    }
+                }
+                total += sum;
+            });
+        }
+        for (auto &w: workers) w.join();
+        return total.load();
+    });
+}
+
+int main() {
+    auto keys = random_int_keys(count, 1);
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1U);
+    for (unsigned int wp: {1U, 10U, 50U}) {
+        ShardedHashMap<std::size_t, std::size_t> sharded;
+        bench_mix("ShardedHashMap", sharded, keys, threads, wp);
+        LockedMap locked;
+        bench_mix("OpenHashMap + mutex", locked, keys, threads, wp);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <cpp.20/flatmap.hpp>
+#include "../common/bench.hpp"
+
+constexpr std::size_t count = 1000000;
+
+///building of maps of given size from unsorted keys
+template<typename Keys>
+void bench_build(std::string_view name, const Keys &keys, std::size_t items) {
+    std::string prefix = std::string(name) + ", " + std::to_string(items) + " items";
+    using K = typename Keys::value_type;
+    auto ops = keys.size() / items * items;
+    benchmark(prefix + " try_emplace", ops, [&]{
+        std::size_t sz = 0;
+        for (std::size_t b = 0; b + items <= keys.size(); b += items) {
+            FlatMap<K, std::size_t> map;
+            for (std::size_t i = b; i < b + items; ++i) map.try_emplace(keys[i], i);
+            sz += map.size();
+        }
+        return sz;
+    });
+    benchmark(prefix + " append, commit", ops, [&]{
+        std::size_t sz = 0;
+        for (std::size_t b = 0; b + items <= keys.size(); b += items) {
+            FlatMap<K, std::size_t> map;
+            map.reserve(items);
+            for (std::size_t i = b; i < b + items; ++i) map.append(keys[i], i);
+            map.commit();
+            sz += map.size();
+        }
+        return sz;
+    });
+    benchmark(prefix + " insert_range", ops, [&]{
+        std::size_t sz = 0;
+        std::vector<std::pair<K, std::size_t> > tmp;
+        for (std::size_t b = 0; b + items <= keys.size(); b += items) {
+            tmp.clear();
+            for (std::size_t i = b; i < b + items; ++i) tmp.emplace_back(keys[i], i);
+            FlatMap<K, std::size_t> map;
+            map.insert_range(std::move(tmp));
+            sz += map.size();
+        }
+        return sz;
+    });
+}
+
+///random lookups, binary search vs. search index (freeze)
+void bench_find(std::size_t items, std::size_t lookups) {
+    std::string prefix = "int, " + std::to_string(items) + " items";
+    auto keys = random_int_keys(items, 3);
+    FlatMap<std::size_t, std::size_t> map;
+    map.reserve(items);
+    for (std::size_t i = 0; i < items; ++i) map.append(keys[i], i);
+    map.commit();
+    std::vector<std::size_t> lookup(lookups);
+    std::mt19937_64 rnd(4);
+    for (auto &x: lookup) x = (rnd() & 1) ? keys[rnd() % items] : static_cast<std::size_t>(rnd());
+    auto run = [&]{
+        std::size_t found = 0;
+        for (auto k: lookup) {
+            auto iter = map.find(k);
+            if (iter != map.end()) found += iter->second;
+        }
+        return found;
+    };
+    benchmark(prefix + " find", lookups, run);
+    benchmark(prefix + " find, lower_bound", lookups, [&]{
+        std::size_t found = 0;
+        for (auto k: lookup) found += static_cast<std::size_t>(map.lower_bound(k) - map.begin());
+        return found;
+    });
+    map.freeze();
+    benchmark(prefix + " find, frozen", lookups, run);
+    benchmark(prefix + " find, lower_bound, frozen", lookups, [&]{
+        std::size_t found = 0;
+        for (auto k: lookup) found += static_cast<std::size_t>(map.lower_bound(k) - map.begin());
+        return found;
+    });
+}
+
+///field access of small maps (like objects of JSON)
+void bench_small_find(std::string_view name, std::size_t items, bool frozen) {
+    std::string prefix = std::string(name) + ", " + std::to_string(items) + " items";
+    constexpr std::size_t maps = 10000;
+    auto keys = random_string_keys(items, 8, 5);
+    for (auto &k: keys) k.resize(4 + k.size() % 5 + (k[0] % 8));
+    std::vector<FlatMap<std::string, std::size_t, std::less<> > > objects(maps);
+    for (std::size_t i = 0; i < maps; ++i) {
+        for (std::size_t j = 0; j < items; ++j) objects[i].try_emplace(keys[j], j);
+        if (frozen) objects[i].freeze();
+    }
+    std::vector<std::string_view> lookup;
+    std::mt19937_64 rnd(6);
+    for (std::size_t i = 0; i < maps; ++i) lookup.push_back(keys[rnd() % items]);
+    benchmark(prefix + " find", maps * 20, [&]{
+        std::size_t sum = 0;
+        for (std::size_t r = 0; r < 20; ++r) {
+            for (std::size_t i = 0; i < maps; ++i) {
+                sum += objects[i].find(lookup[(i + r) % maps])->second;
+            }
+        }
+        return sum;
+    });
+}
+
+int main() {
+    auto int_keys = random_int_keys(count, 1);
+    auto str_keys = random_string_keys(count, 16, 1);
+    for (std::size_t items: {8, 1000, 50000}) {
+        bench_build("int", int_keys, items);
+        bench_build("string", str_keys, items);
+    }
+    for (std::size_t items: {4, 8, 16}) {
+        bench_small_find("string, binary search", items, false);
+        bench_small_find("string, frozen scan", items, true);
+    }
+    for (std::size_t items: {1000, 100000, 1000000, 10000000}) {
+        bench_find(items, 2000000);
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <cpp.20/json.hpp>
+#include "../common/bench.hpp"
+
+///Generate document - array of records with strings, numbers and nested objects
+static std::string generate_document(std::size_t records) {
+    std::mt19937_64 rnd(1);
+    auto words = random_string_keys(1000, 12, 2);
+    std::string out = "[\n";
+    for (std::size_t i = 0; i < records; ++i) {
+        if (i) out.append(",\n");
+        out.append("  {\"id\": ").append(std::to_string(i));
+        out.append(", \"name\": \"").append(words[rnd() % words.size()]).append("\"");
+        out.append(", \"score\": ").append(std::to_string(static_cast<double>(rnd() % 100000) / 100.0));
+        out.append(", \"active\": ").append(rnd() & 1 ? "true" : "false");
+        out.append(", \"tags\": [\"").append(words[rnd() % words.size()]).append("\", \"")
+           .append(words[rnd() % words.size()]).append("\"]");
+        out.append(", \"address\": {\"city\": \"").append(words[rnd() % words.size()])
+           .append("\", \"zip\": ").append(std::to_string(rnd() % 100000))
+           .append(", \"note\": \"line\\nbreak \\u00e9\"}}");
+    }
+    out.append("\n]\n");
+    return out;
+}
+
+int main() {
+    auto doc = generate_document(100000);
+    std::cout << "document size: " << doc.size() / 1000 << " kB" << std::endl;
+    benchmark_throughput("parse, callback", doc.size(), [&]{
+        std::size_t pos = 0;
+        auto j = Json::parse([&]() -> std::optional<char> {
+            if (pos < doc.size()) return doc[pos++];
+            return {};
+        });
+        return j.as_array().size();
+    });
+    benchmark_throughput("parse, string_view", doc.size(), [&]{
+        return Json::parse(std::string_view(doc)).as_array().size();
+    });
+    benchmark_throughput("parse, string_view, interned keys", doc.size(), [&]{
+        return Json::parse(std::string_view(doc), true).as_array().size();
+    });
+    benchmark_throughput("structural index only", doc.size(), [&]{
+        JsonStructuralIndex index;
+        index.build(doc);
+        return index.positions().size();
+    });
+    benchmark_throughput("parse, indexed", doc.size(), [&]{
+        return Json::parse_indexed(doc).as_array().size();
+    });
+    benchmark_throughput("parse, indexed, interned keys", doc.size(), [&]{
+        return Json::parse_indexed(doc, true).as_array().size();
+    });
+    benchmark_throughput("parse + destroy, JsonDocument", doc.size(), [&]{
+        return JsonDocument::parse(std::string_view(doc))->as_array().size();
+    });
+    benchmark_throughput("parse + destroy, monotonic resource", doc.size(), [&]{
+        std::pmr::monotonic_buffer_resource mr(doc.size());
+        return Json::parse(std::string_view(doc), false, &mr).as_array().size();
+    });
+    benchmark_throughput("SAX, 64kB chunks", doc.size(), [&]{
+        struct Counter {
+            std::size_t events = 0;
+            void start_object() {++events;}
+            void end_object() {++events;}
+            void start_array() {++events;}
+            void end_array() {++events;}
+            void key(std::string_view) {++events;}
+            void string(std::string_view) {++events;}
+            void number(std::string_view) {++events;}
+            void boolean(bool) {++events;}
+            void null() {++events;}
+        };
+        JsonSaxParser<Counter> parser;
+        std::string_view rest(doc);
+        while (!rest.empty()) {
+            auto chunk = rest.substr(0, 65536);
+            parser.feed(chunk);
+            rest = rest.substr(chunk.size());
+        }
+        parser.finish();
+        return parser.handler().events;
+    });
+    {
+        //teardown of 1MB documents
+        auto small = generate_document(5000);
+        constexpr std::size_t docs = 20;
+        std::vector<Json> heap;
+        std::vector<JsonDocument> arena;
+        for (std::size_t i = 0; i < docs; ++i) {
+            heap.push_back(Json::parse(std::string_view(small)));
+            arena.push_back(JsonDocument::parse(std::string_view(small)));
+        }
+        benchmark("destroy 1MB document, Json", docs, [&]{heap.clear();});
+        benchmark("destroy 1MB document, JsonDocument", docs, [&]{arena.clear();});
+    }
+
+    {
+        //field access of parsed records (the parser freezes small objects)
+        auto records = Json::parse(std::string_view(doc));
+        auto access = [&]{
+            std::size_t r = 0;
+            for (const Json &rec: records.as_array()) {
+                r += rec["name"].as_text().size() + static_cast<std::size_t>(rec["address"]["zip"].as_int())
+                   + rec["active"].as_bool() + rec["tags"].as_array().size();
+            }
+            return r;
+        };
+        std::size_t ops = records.as_array().size() * 5;
+        benchmark("field access, frozen objects", ops, access);
+        records.update([](Json::Array &arr) {
+            for (auto &rec: arr) rec.update([](Json::Object &obj) {
+                obj.unfreeze();
+                for (auto &item: obj) {
+                    if (item.second.is_object()) item.second.update([](Json::Object &sub) {sub.unfreeze();});
+                }
+            });
+        });
+        benchmark("field access, binary search", ops, access);
+    }
+
+    //request, where handler reads few fields
+    std::string request = R"({"records":)" + generate_document(200) + R"(,"user":"admin","id":5})";
+    constexpr std::size_t requests = 1000;
+    std::cout << "request size: " << request.size() / 1000 << " kB" << std::endl;
+    benchmark("read 3 fields, parse", requests, [&]{
+        std::size_t r = 0;
+        for (std::size_t i = 0; i < requests; ++i) {
+            auto j = Json::parse(std::string_view(request));
+            r += j["id"].as_int() + j["user"].as_text().size() + j["records"][100]["name"].as_text().size();
+        }
+        return r;
+    });
+    benchmark("read 3 fields, JsonView", requests, [&]{
+        std::size_t r = 0;
+        for (std::size_t i = 0; i < requests; ++i) {
+            JsonView j(request);
+            r += j["id"].as_int() + j["user"].as_text().size() + j["records"][100]["name"].as_text().size();
+        }
+        return r;
+    });
+    return 0;
+}
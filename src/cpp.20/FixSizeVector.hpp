@@ -2,30 +2,96 @@
 #ifndef uuid_84348b5a_c15c_4ca0_9bb7_13e56d657771
 #define uuid_84348b5a_c15c_4ca0_9bb7_13e56d657771
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <span>
+#include <type_traits>
+#include <utility>
 
 
+///Allocator, which aligns memory to given alignment (cache line by default)
+/**
+@tparam T item type
+@tparam alignment required alignment
+In constant evaluation, std::allocator is used
+ */
+template<typename T, std::size_t alignment = 64>
+class AlignedAllocator {
+public:
+    static_assert(alignment >= alignof(T) && (alignment & (alignment - 1)) == 0, "Invalid alignment");
+
+    using value_type = T;
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, (std::max)(alignment, alignof(U))>;
+    };
+
+    constexpr AlignedAllocator() = default;
+    template<typename U, std::size_t a>
+    constexpr AlignedAllocator(const AlignedAllocator<U, a> &) {}
+
+    constexpr T *allocate(std::size_t n) {
+        if (std::is_constant_evaluated()) return std::allocator<T>().allocate(n);
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    constexpr void deallocate(T *p, std::size_t n) {
+        if (std::is_constant_evaluated()) return std::allocator<T>().deallocate(p, n);
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    template<typename U, std::size_t a>
+    constexpr bool operator==(const AlignedAllocator<U, a> &) const {return true;}
+};
+
 ///Defines fix size vector allocated in runtime
 /**
 @tparam T item type
+@tparam Alloc allocator. Use AlignedAllocator for cache line aligned storage,
+HugePageAllocator (see HugePageAllocator.hpp) for very large arrays or std::pmr::polymorphic_allocator (see
+pmr::FixSizeVector) to allocate from a memory resource.
 
 Just like vector, but cannot resize, it has fixed size, the code is simplier
+
+Items are default initialized, so items of trivial types are not initialized
+and memory of the array is not touched during construction (at runtime). In
+constant evaluation, items are always value initialized
  */
-template<typename T>
+template<typename T, typename Alloc = std::allocator<T> >
 class FixSizeVector: public std::span<T> {
+
+    using Traits = std::allocator_traits<Alloc>;
+
 public:
 
+    using allocator_type = Alloc;
+
     constexpr FixSizeVector() = default;
-    constexpr FixSizeVector(std::size_t cnt):std::span<T>(cnt?new T[cnt]:nullptr, cnt) {}
+    constexpr FixSizeVector(std::size_t cnt, const Alloc &alloc = Alloc())
+        :_alloc(alloc) {
+        init(cnt, [](T *p) {
+            if (std::is_constant_evaluated()) std::construct_at(p);
+            else if constexpr(!std::is_trivially_default_constructible_v<T>) std::uninitialized_default_construct_n(p, 1);
+        });
+    }
+    ///Construct array filled by given value
+    constexpr FixSizeVector(std::size_t cnt, const T &value, const Alloc &alloc = Alloc())
+        :_alloc(alloc) {
+        init(cnt, [&](T *p) {std::construct_at(p, value);});
+    }
     constexpr ~FixSizeVector() {
-        T *ptr = this->data();
-        delete [] ptr;
+        release();
     }
 
     constexpr FixSizeVector(const FixSizeVector &other)
-        :FixSizeVector(other._size())
+        :std::span<T>()
+        ,_alloc(Traits::select_on_container_copy_construction(other._alloc))
     {
-        std::copy(other.begin(), other.end(), this->begin());
+        auto src = other.begin();
+        init(other.size(), [&](T *p) {std::construct_at(p, *src++);});
     }
     constexpr FixSizeVector &operator=(const FixSizeVector &other) {
         if (this != &other) {
@@ -34,7 +100,9 @@ public:
         }
         return *this;
     }
-    constexpr FixSizeVector(FixSizeVector &&other):std::span<T>(std::move(other)) {
+    constexpr FixSizeVector(FixSizeVector &&other)
+        :std::span<T>(std::move(other))
+        ,_alloc(std::move(other._alloc)) {
         other.std::span<T>::operator=(std::span<T>());
     }
 
@@ -46,9 +114,168 @@ public:
         }
         return *this;
     }
-    
 
+    constexpr Alloc get_allocator() const {
+        return _alloc;
+    }
+
+protected:
+
+    [[no_unique_address]] Alloc _alloc = {};
+
+    template<typename Fn>
+    constexpr void init(std::size_t cnt, Fn &&construct) {
+        if (!cnt) return;
+        T *ptr = Traits::allocate(_alloc, cnt);
+        std::size_t i = 0;
+        try {
+            for (; i < cnt; ++i) construct(ptr + i);
+        } catch (...) {
+            std::destroy_n(ptr, i);
+            Traits::deallocate(_alloc, ptr, cnt);
+            throw;
+        }
+        std::span<T>::operator=(std::span<T>(ptr, cnt));
+    }
+
+    constexpr void release() {
+        T *ptr = this->data();
+        if (!ptr) return;
+        if (std::is_constant_evaluated() || !std::is_trivially_destructible_v<T>) {
+            std::destroy_n(ptr, this->size());
+        }
+        Traits::deallocate(_alloc, ptr, this->size());
+    }
+
+};
+
+///Fix size vector, which stores up to N items inline (without allocation)
+/**
+@tparam T item type
+@tparam N count of items stored inline
+@tparam Alloc allocator used for arrays larger than N items
+
+Arrays of up to N items are stored in a buffer inside of the object, larger arrays
+are allocated by the allocator. Inline items are moved item by item when the vector
+is moved, so pointers to items are not stable across moves. In constant evaluation,
+the items are always allocated by the allocator
+ */
+template<typename T, std::size_t N, typename Alloc = std::allocator<T> >
+class InlineFixSizeVector: public std::span<T> {
+
+    using Traits = std::allocator_traits<Alloc>;
+
+public:
+
+    using allocator_type = Alloc;
+    static constexpr std::size_t inline_capacity = N;
+
+    constexpr InlineFixSizeVector() = default;
+    constexpr InlineFixSizeVector(std::size_t cnt, const Alloc &alloc = Alloc())
+        :_alloc(alloc) {
+        init(cnt, [](T *p) {
+            if (std::is_constant_evaluated()) std::construct_at(p);
+            else if constexpr(!std::is_trivially_default_constructible_v<T>) std::uninitialized_default_construct_n(p, 1);
+        });
+    }
+    ///Construct array filled by given value
+    constexpr InlineFixSizeVector(std::size_t cnt, const T &value, const Alloc &alloc = Alloc())
+        :_alloc(alloc) {
+        init(cnt, [&](T *p) {std::construct_at(p, value);});
+    }
+    constexpr ~InlineFixSizeVector() {
+        release();
+    }
+
+    constexpr InlineFixSizeVector(const InlineFixSizeVector &other)
+        :std::span<T>()
+        ,_alloc(Traits::select_on_container_copy_construction(other._alloc))
+    {
+        auto src = other.begin();
+        init(other.size(), [&](T *p) {std::construct_at(p, *src++);});
+    }
+    constexpr InlineFixSizeVector &operator=(const InlineFixSizeVector &other) {
+        if (this != &other) {
+            std::destroy_at(this);
+            std::construct_at(this, other);
+        }
+        return *this;
+    }
+    constexpr InlineFixSizeVector(InlineFixSizeVector &&other)
+        :std::span<T>()
+        ,_alloc(std::move(other._alloc)) {
+        if (other.is_inline()) {
+            auto src = other.begin();
+            init(other.size(), [&](T *p) {std::construct_at(p, std::move(*src++));});
+            other.release();
+        } else {
+            std::span<T>::operator=(other);
+        }
+        other.std::span<T>::operator=(std::span<T>());
+    }
+    constexpr InlineFixSizeVector &operator=(InlineFixSizeVector &&other) {
+        if (this != &other) {
+            std::destroy_at(this);
+            std::construct_at(this, std::move(other));
+        }
+        return *this;
+    }
+
+    constexpr Alloc get_allocator() const {
+        return _alloc;
+    }
+
+    ///Returns true, if items are stored inside of the object
+    constexpr bool is_inline() const {
+        return !std::is_constant_evaluated() && this->data() && this->data() == inline_data();
+    }
+
+protected:
+
+    [[no_unique_address]] Alloc _alloc = {};
+    alignas(T) unsigned char _buffer[N?N * sizeof(T):1];
+
+    T *inline_data() const {
+        return reinterpret_cast<T *>(const_cast<unsigned char *>(_buffer));
+    }
+
+    template<typename Fn>
+    constexpr void init(std::size_t cnt, Fn &&construct) {
+        if (!cnt) return;
+        bool in = !std::is_constant_evaluated() && cnt <= N;
+        T *ptr = in?inline_data():Traits::allocate(_alloc, cnt);
+        std::size_t i = 0;
+        try {
+            for (; i < cnt; ++i) construct(ptr + i);
+        } catch (...) {
+            std::destroy_n(ptr, i);
+            if (!in) Traits::deallocate(_alloc, ptr, cnt);
+            throw;
+        }
+        std::span<T>::operator=(std::span<T>(ptr, cnt));
+    }
+
+    constexpr void release() {
+        T *ptr = this->data();
+        if (!ptr) return;
+        if (std::is_constant_evaluated() || !std::is_trivially_destructible_v<T>) {
+            std::destroy_n(ptr, this->size());
+        }
+        if (!is_inline()) Traits::deallocate(_alloc, ptr, this->size());
+    }
 
 };
 
-#endif
\ No newline at end of file
+namespace pmr {
+
+///FixSizeVector, which allocates from std::pmr::memory_resource
+template<typename T>
+using FixSizeVector = ::FixSizeVector<T, std::pmr::polymorphic_allocator<T> >;
+
+///InlineFixSizeVector, which allocates large arrays from std::pmr::memory_resource
+template<typename T, std::size_t N>
+using InlineFixSizeVector = ::InlineFixSizeVector<T, N, std::pmr::polymorphic_allocator<T> >;
+
+}
+
+#endif
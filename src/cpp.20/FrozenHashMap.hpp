@@ -0,0 +1,306 @@
+/**
+@file FrozenHashMap.hpp
+
+Immutable hash map built at compile time using minimal perfect hashing
+
+@code
+constexpr auto keywords = make_frozen_hash_map<std::string_view, int>({
+    {"if", 1}, {"else", 2}, {"while", 3}, {"return", 4}
+});
+
+auto iter = keywords.find("while");
+@endcode
+
+The map is literal type, so it can be declared as constexpr variable and placed into
+static storage. There is no runtime initialization.
+
+*/
+
+#pragma once
+#ifndef uuid5c1f6e0d_2a8b_4f3e_9d71_b4e0a6c2d817
+#define uuid5c1f6e0d_2a8b_4f3e_9d71_b4e0a6c2d817
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+///Default hasher for FrozenHashMap
+/** Hasher must be usable in constant evaluation, which is not true for std::hash. This
+hasher supports integral types, enums and strings (anything convertible to std::string_view).
+It is transparent, so strings can be searched by std::string_view */
+struct FrozenHash {
+    using is_transparent = void;
+
+    template<typename T>
+    requires(std::is_integral_v<T> || std::is_enum_v<T>)
+    constexpr std::size_t operator()(T v) const {
+        return static_cast<std::size_t>(v);
+    }
+
+    ///FNV-1a
+    constexpr std::size_t operator()(std::string_view s) const {
+        std::uint64_t h = 14695981039346656037ULL;
+        for (char c: s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ULL;
+        }
+        return static_cast<std::size_t>(h);
+    }
+};
+
+namespace _details {
+
+///Mix hash with seed
+constexpr std::uint64_t frozen_hash_mix(std::uint64_t h, std::uint64_t seed) {
+    h ^= seed * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+///Map 32 bit value to range 0 - n-1 without division
+constexpr std::size_t frozen_hash_reduce(std::uint64_t h, std::size_t n) {
+    return static_cast<std::size_t>(((h & 0xFFFFFFFFULL) * n) >> 32);
+}
+
+}
+
+///Immutable hash map built at compile time
+/**
+The map uses "hash and displace" minimal perfect hashing. Keys are distributed into
+buckets (two keys per bucket in average), and for each bucket a seed is found, which places
+all keys of the bucket into free slots. The table has exactly N slots, one per item.
+
+The lookup calculates the hash, reads the seed of its bucket and compares the
+key at the computed slot. There is no probing.
+
+@tparam K key type. It must be a literal type (use std::string_view for strings)
+@tparam V value type. It must be a literal type
+@tparam N count of items
+@tparam Hash hash function, must be constexpr callable. See FrozenHash
+@tparam Equal compare function
+
+@note Keys must be unique. Duplicated key causes an exception, which is reported
+as compile error when the map is built in constant evaluation
+ */
+template<typename K, typename V, std::size_t N, typename Hash = FrozenHash, typename Equal = std::equal_to<K> >
+class FrozenHashMap {
+public:
+
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using const_iterator = const value_type *;
+    using iterator = const_iterator;
+
+    ///true if both hasher and compare function are transparent
+    static constexpr bool transparent = requires {
+        typename Hash::is_transparent;
+        typename Equal::is_transparent;
+    };
+
+    ///Count of buckets
+    static constexpr std::size_t bucket_count = N / 2 + 1;
+
+    ///Build the map
+    /**
+    @param items items to store. Order of items is not preserved
+    @param hasher instance of hasher
+    @param equal instance of compare function
+    @exception std::invalid_argument duplicated key or keys with same hash
+     */
+    constexpr FrozenHashMap(const std::array<value_type, N> &items, Hash hasher = {}, Equal equal = {})
+        :FrozenHashMap(build(items, hasher, equal), items, hasher, equal, std::make_index_sequence<N>()) {}
+
+    constexpr const_iterator begin() const {return _items.data();}
+    constexpr const_iterator end() const {return _items.data() + N;}
+    constexpr std::size_t size() const {return N;}
+    constexpr bool empty() const {return N == 0;}
+
+    constexpr Hash hash_function() const {return _hasher;}
+    constexpr Equal key_eq() const {return _eq;}
+
+    constexpr const_iterator find(const K &key) const {
+        return find_hashed(key, _hasher(key));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key) const {
+        return find_hashed(key, _hasher(key));
+    }
+
+    ///Find with precalculated hash
+    /**
+    @param key key to find
+    @param hash result of hash_function() for the key
+     */
+    constexpr const_iterator find(const K &key, std::size_t hash) const {
+        return find_hashed(key, hash);
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key, std::size_t hash) const {
+        return find_hashed(key, hash);
+    }
+
+    constexpr bool contains(const K &key) const {
+        return find(key) != end();
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr bool contains(const Key &key) const {
+        return find(key) != end();
+    }
+
+    constexpr std::size_t count(const K &key) const {
+        return contains(key)?1:0;
+    }
+
+    constexpr const V &at(const K &key) const {
+        auto iter = find(key);
+        if (iter == end()) throw std::out_of_range("FrozenHashMap::at - key not found");
+        return iter->second;
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const V &at(const Key &key) const {
+        auto iter = find(key);
+        if (iter == end()) throw std::out_of_range("FrozenHashMap::at - key not found");
+        return iter->second;
+    }
+
+protected:
+
+    ///Result of the build - seeds and position of items in the table
+    struct Layout {
+        std::array<std::uint32_t, bucket_count> seeds = {};
+        std::array<std::size_t, N> order = {};
+    };
+
+    std::array<std::uint32_t, bucket_count> _seeds;
+    std::array<value_type, N> _items;
+    [[no_unique_address]] Hash _hasher;
+    [[no_unique_address]] Equal _eq;
+
+    template<std::size_t ... idx>
+    constexpr FrozenHashMap(const Layout &layout, const std::array<value_type, N> &items,
+                            const Hash &hasher, const Equal &equal, std::index_sequence<idx...>)
+        :_seeds(layout.seeds)
+        ,_items{{items[layout.order[idx]]...}}
+        ,_hasher(hasher)
+        ,_eq(equal) {}
+
+    static constexpr std::size_t bucket_of(std::uint64_t h) {
+        return _details::frozen_hash_reduce(h >> 32, bucket_count);
+    }
+
+    static constexpr std::size_t slot_of(std::uint64_t h, std::uint32_t seed) {
+        return _details::frozen_hash_reduce(_details::frozen_hash_mix(h, seed), N);
+    }
+
+    template<typename Key>
+    constexpr const_iterator find_hashed(const Key &key, std::size_t hash) const {
+        if constexpr(N == 0) {
+            return end();
+        } else {
+            auto h = _details::frozen_hash_mix(hash, 0);
+            const value_type *item = _items.data() + slot_of(h, _seeds[bucket_of(h)]);
+            return _eq(item->first, key)?item:end();
+        }
+    }
+
+    static constexpr Layout build(const std::array<value_type, N> &items, const Hash &hasher, const Equal &equal) {
+        Layout out;
+        if constexpr(N > 0) {
+            std::array<std::uint64_t, N> hashes = {};
+            std::array<std::size_t, bucket_count + 1> start = {};
+            for (std::size_t i = 0; i < N; ++i) {
+                hashes[i] = _details::frozen_hash_mix(hasher(items[i].first), 0);
+                ++start[bucket_of(hashes[i]) + 1];
+            }
+            for (std::size_t b = 0; b < bucket_count; ++b) start[b + 1] += start[b];
+            //members of buckets, bucket b occupies start[b] - start[b+1]
+            std::array<std::size_t, N> members = {};
+            std::array<std::size_t, bucket_count> fill = {};
+            for (std::size_t i = 0; i < N; ++i) {
+                auto b = bucket_of(hashes[i]);
+                members[start[b] + fill[b]++] = i;
+            }
+            //process largest buckets first
+            std::array<std::size_t, bucket_count> buckets = {};
+            for (std::size_t b = 0; b < bucket_count; ++b) buckets[b] = b;
+            std::sort(buckets.begin(), buckets.end(), [&](std::size_t a, std::size_t b) {
+                auto sa = start[a + 1] - start[a];
+                auto sb = start[b + 1] - start[b];
+                return sa == sb?a < b:sa > sb;
+            });
+            std::array<bool, N> used = {};
+            std::array<std::size_t, N> slots = {};
+            for (std::size_t b: buckets) {
+                std::size_t beg = start[b];
+                std::size_t cnt = start[b + 1] - beg;
+                if (cnt == 0) break;
+                for (std::size_t i = 1; i < cnt; ++i) {
+                    for (std::size_t j = 0; j < i; ++j) {
+                        const auto &a = members[beg + i];
+                        const auto &c = members[beg + j];
+                        if (hashes[a] == hashes[c]) {
+                            if (equal(items[a].first, items[c].first)) {
+                                throw std::invalid_argument("FrozenHashMap: duplicate key");
+                            }
+                            throw std::invalid_argument("FrozenHashMap: keys have same hash");
+                        }
+                    }
+                }
+                std::uint32_t seed = 1;
+                while (true) {
+                    std::size_t placed = 0;
+                    for (; placed < cnt; ++placed) {
+                        auto s = slot_of(hashes[members[beg + placed]], seed);
+                        if (used[s]) break;
+                        used[s] = true;
+                        slots[placed] = s;
+                    }
+                    if (placed == cnt) break;
+                    //rollback
+                    for (std::size_t i = 0; i < placed; ++i) used[slots[i]] = false;
+                    if (++seed == 0) throw std::invalid_argument("FrozenHashMap: unable to build perfect hash");
+                }
+                out.seeds[b] = seed;
+                for (std::size_t i = 0; i < cnt; ++i) out.order[slots[i]] = members[beg + i];
+            }
+        }
+        return out;
+    }
+};
+
+template<typename K, typename V, std::size_t N, typename Hash = FrozenHash, typename Equal = std::equal_to<K> >
+FrozenHashMap(const std::array<std::pair<K, V>, N> &, Hash = {}, Equal = {}) -> FrozenHashMap<K, V, N, Hash, Equal>;
+
+///Build frozen hash map from list of items
+/**
+@tparam K key type
+@tparam V value type
+@param items list of items in braces
+@return FrozenHashMap
+ */
+template<typename K, typename V, typename Hash = FrozenHash, typename Equal = std::equal_to<K>, std::size_t N>
+constexpr FrozenHashMap<K, V, N, Hash, Equal> make_frozen_hash_map(const std::pair<K, V> (&items)[N], Hash hasher = {}, Equal equal = {}) {
+    return FrozenHashMap<K, V, N, Hash, Equal>(std::to_array(items), hasher, equal);
+}
+
+
+#endif
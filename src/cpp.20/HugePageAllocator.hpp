@@ -0,0 +1,84 @@
+/**
+@file HugePageAllocator.hpp
+
+Allocator of large blocks backed by huge pages. It is kept apart from FixSizeVector.hpp,
+so only the code, which uses it, includes the headers of the OS
+
+*/
+
+#pragma once
+#ifndef uuid7095620f_35a6_44a4_9252_297295435415
+#define uuid7095620f_35a6_44a4_9252_297295435415
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "FixSizeVector.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+///Allocator, which allocates large blocks directly from the OS, backed by huge pages if possible
+/**
+Blocks smaller than `threshold` are allocated by AlignedAllocator (cache line aligned).
+Larger blocks are mapped as anonymous memory (page aligned, zero filled, pages are committed
+on first access). On Linux, transparent huge pages are requested for these blocks.
+In constant evaluation, std::allocator is used
+ */
+template<typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    static constexpr std::size_t threshold = 2 * 1024 * 1024;
+
+    constexpr HugePageAllocator() = default;
+    template<typename U>
+    constexpr HugePageAllocator(const HugePageAllocator<U> &) {}
+
+    constexpr T *allocate(std::size_t n) {
+        if (std::is_constant_evaluated()) return std::allocator<T>().allocate(n);
+        std::size_t bytes = n * sizeof(T);
+        if (bytes < threshold) return Small().allocate(n);
+#ifdef _WIN32
+        void *p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!p) throw std::bad_alloc();
+#else
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+        return static_cast<T *>(p);
+    }
+
+    constexpr void deallocate(T *p, std::size_t n) {
+        if (std::is_constant_evaluated()) return std::allocator<T>().deallocate(p, n);
+        std::size_t bytes = n * sizeof(T);
+        if (bytes < threshold) return Small().deallocate(p, n);
+#ifdef _WIN32
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        ::munmap(p, bytes);
+#endif
+    }
+
+    template<typename U>
+    constexpr bool operator==(const HugePageAllocator<U> &) const {return true;}
+
+protected:
+    using Small = AlignedAllocator<T, (std::max<std::size_t>)(64, alignof(T))>;
+};
+
+
+#endif
@@ -0,0 +1,135 @@
+/**
+@file MappedFile.hpp
+
+Read-only memory mapped file
+
+*/
+
+#pragma once
+#ifndef uuid8d3e41b7_6c02_4a5f_b9e8_27f1c0d4a963
+#define uuid8d3e41b7_6c02_4a5f_b9e8_27f1c0d4a963
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+///Maps whole file into memory for reading
+/**
+Pages are loaded on demand and they are shared between processes, which map the
+same file. The object is movable, not copyable. The mapping is released in destructor
+ */
+class MappedFile {
+public:
+
+    MappedFile() = default;
+
+    ///Map file
+    /**
+    @param path path to file
+    @exception std::system_error unable to open or map the file
+     */
+    explicit MappedFile(const std::filesystem::path &path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw_error("MappedFile: open");
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz)) {
+            CloseHandle(file);
+            throw_error("MappedFile: size");
+        }
+        _size = static_cast<std::size_t>(sz.QuadPart);
+        if (_size) {
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (!mapping) throw_error("MappedFile: map");
+            _data = static_cast<const std::byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+            if (!_data) throw_error("MappedFile: map");
+        } else {
+            CloseHandle(file);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw_error("MappedFile: open");
+        struct stat st;
+        if (::fstat(fd, &st)) {
+            ::close(fd);
+            throw_error("MappedFile: stat");
+        }
+        _size = static_cast<std::size_t>(st.st_size);
+        if (_size) {
+            void *p = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED) throw_error("MappedFile: mmap");
+            _data = static_cast<const std::byte *>(p);
+        } else {
+            ::close(fd);
+        }
+#endif
+    }
+
+    MappedFile(MappedFile &&other)
+        :_data(std::exchange(other._data, nullptr))
+        ,_size(std::exchange(other._size, 0)) {}
+
+    MappedFile &operator=(MappedFile &&other) {
+        if (this != &other) {
+            release();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        release();
+    }
+
+    const std::byte *data() const {return _data;}
+    std::size_t size() const {return _size;}
+    std::span<const std::byte> bytes() const {return {_data, _size};}
+
+protected:
+    const std::byte *_data = nullptr;
+    std::size_t _size = 0;
+
+    void release() {
+        if (!_data) return;
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        ::munmap(const_cast<std::byte *>(_data), _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    [[noreturn]] static void throw_error(const char *what) {
+#ifdef _WIN32
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+        throw std::system_error(errno, std::generic_category(), what);
+#endif
+    }
+};
+
+
+#endif
@@ -8,11 +8,374 @@ Hash map with open addressing constexpr testable
 #pragma once
 #ifndef uuid32a785b3_a515_42f5_8099_f9dfddecf763
 #define uuid32a785b3_a515_42f5_8099_f9dfddecf763
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
 #include <cstdint>
 #include <functional>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include "FixSizeVector.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOOLBOX_OPENHASHMAP_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TOOLBOX_OPENHASHMAP_NEON 1
+#endif
 
+namespace _details {
+
+///Improve quality of the hash, as std::hash is often identity
+/** Result is multiplied by golden ratio, so highest bits are well distributed */
+constexpr std::size_t hash_map_mix(std::size_t hash) {
+    if constexpr(sizeof(std::size_t) == 4) {
+        constexpr std::uint32_t multiplier = 2654435761U;
+        hash ^= (hash >> 5) ^ (hash << 7);
+        hash *= multiplier;
+    } else {
+        constexpr std::uint64_t multiplier = 11400714819323198485ULL;
+        hash ^= (hash >> 7) ^ (hash << 11);
+        hash *= multiplier;
+    }
+    return hash;
+}
+
+///Hint CPU to load memory into cache
+constexpr void hash_map_prefetch(const void *ptr) {
+    if (std::is_constant_evaluated()) return;
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#elif defined(TOOLBOX_OPENHASHMAP_SSE2)
+    _mm_prefetch(static_cast<const char *>(ptr), _MM_HINT_T0);
+#else
+    (void)ptr;
+#endif
+}
+
+///Group of control bytes, which are tested at once
+/**
+Each slot of the hash map has one control byte. The byte is either `empty`, `deleted` or it
+contains 7 bit fingerprint of the hash of the key stored in the slot. The group
+compares whole group of control bytes at once (using SSE2 or NEON) and returns
+bitmask of matching slots. In constant evaluation, scalar code is used.
+
+The mask has 1 bit per slot (SSE2, scalar). On NEON, the mask has 4 bits per slot, only
+lowest bit of each nibble is set. Use index() to convert bit position to slot index
+ */
+struct HashMapGroup {
+
+    using Mask = std::uint64_t;
+
+    static constexpr std::size_t width = 16;
+    static constexpr std::uint8_t empty = 0x80;
+    ///marks slot, which is not occupied, but it is part of a probe sequence
+    static constexpr std::uint8_t deleted = 0xFE;
+#ifdef TOOLBOX_OPENHASHMAP_NEON
+    static constexpr unsigned int shift = 2;
+#else
+    static constexpr unsigned int shift = 0;
+#endif
+
+    ///Mask of slots matching the fingerprint
+    static constexpr Mask match(const std::uint8_t *ctrl, std::uint8_t h2) {
+        if (std::is_constant_evaluated()) {
+            return match_scalar(ctrl, h2);
+        }
+#if defined(TOOLBOX_OPENHASHMAP_SSE2)
+        auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+        auto m = _mm_cmpeq_epi8(c, _mm_set1_epi8(static_cast<char>(h2)));
+        return static_cast<Mask>(static_cast<unsigned int>(_mm_movemask_epi8(m)));
+#elif defined(TOOLBOX_OPENHASHMAP_NEON)
+        uint8x16_t c = vld1q_u8(ctrl);
+        uint8x16_t m = vceqq_u8(c, vdupq_n_u8(h2));
+        uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(n), 0) & 0x1111111111111111ULL;
+#else
+        return match_scalar(ctrl, h2);
+#endif
+    }
+
+    ///Mask of empty slots
+    static constexpr Mask match_empty(const std::uint8_t *ctrl) {
+        return match(ctrl, empty);
+    }
+
+    ///Mask which covers first n slots of the group
+    static constexpr Mask prefix(std::size_t n) {
+        if (n >= width) return ~Mask(0) >> (64 - (width << shift));
+        return (Mask(1) << (n << shift)) - 1;
+    }
+
+    ///Convert bit position to slot index
+    static constexpr std::size_t index(Mask m) {
+        return static_cast<std::size_t>(std::countr_zero(m)) >> shift;
+    }
+
+    static constexpr Mask match_scalar(const std::uint8_t *ctrl, std::uint8_t h2) {
+        Mask r = 0;
+        for (std::size_t i = 0; i < width; ++i) {
+            if (ctrl[i] == h2) r |= Mask(1) << (i << shift);
+        }
+        return r;
+    }
+};
+
+}
+
+///Capacity policy - capacities are prime numbers, home slot is calculated by modulo
+/** This is default policy. It is more tolerant to poor hash functions, but needs an integer
+division to find home slot of the key */
+struct PrimeCapacity {
+
+    static constexpr std::array<std::size_t, 28> prime_sizes = {
+        5ul, 11ul, 23ul, 47ul, 97ul, 197ul, 397ul,
+        797ul, 1597ul, 3203ul, 6421ul, 12853ul, 25717ul,
+        51437ul, 102877ul, 205759ul, 411527ul, 823117ul,
+        1646237ul, 3292489ul, 6584983ul, 13169977ul,
+        26339969ul, 52679969ul, 105359939ul, 210719881ul,
+        421439783ul, 842879579ul
+    };
+
+    ///capacity used when map is created with given count of slots
+    static constexpr std::size_t initial_capacity(std::size_t count) {
+        return count;
+    }
+
+    ///capacity used when map is expanded
+    static constexpr std::size_t next_capacity(std::size_t current) {
+        for (std::size_t p : prime_sizes)
+            if (p > current) return p;
+        return current * 2 + 1;
+    }
+
+    ///calculate home slot
+    static constexpr std::size_t home_index(std::size_t hash, std::size_t capacity) {
+        return hash % capacity;
+    }
+};
+
+///Capacity policy - capacities are powers of two, home slot is calculated by masking
+/** The home slot is taken from highest bits of the hash (bellow the bits used for fingerprint)
+which is fibonacci hashing, as the hash is already multiplied by golden ratio. There is
+no division in the probe loop */
+struct PowerOfTwoCapacity {
+
+    static constexpr std::size_t initial_capacity(std::size_t count) {
+        return count?std::bit_ceil(count):0;
+    }
+
+    static constexpr std::size_t next_capacity(std::size_t current) {
+        return current < _details::HashMapGroup::width?_details::HashMapGroup::width:current * 2;
+    }
+
+    static constexpr std::size_t home_index(std::size_t hash, std::size_t capacity) {
+        constexpr unsigned int avail_bits = sizeof(std::size_t) * 8 - 7;
+        unsigned int bits = static_cast<unsigned int>(std::countr_zero(capacity));
+        return (hash >> (bits < avail_bits?avail_bits - bits:0)) & (capacity - 1);
+    }
+};
+
+///Tests, whether type is capacity policy
+template<typename T>
+concept HashMapCapacityPolicy = requires(std::size_t n) {
+    {T::initial_capacity(n)} -> std::convertible_to<std::size_t>;
+    {T::next_capacity(n)} -> std::convertible_to<std::size_t>;
+    {T::home_index(n, n)} -> std::convertible_to<std::size_t>;
+};
+
+///Probing policy - Robin Hood hashing
+/**
+Each slot tracks distance of its entry from its home slot. Insertion keeps entries of a
+cluster ordered by their home slot, so the probe lengths are balanced and a lookup of
+missing key stops once it reaches an entry closer to its home. Erase uses backward-shift
+deletion, so no rehashing is needed. The distance is stored in one byte per slot. If the
+distance overflows (because too many keys share the same home slot), the map is expanded
+and if that doesn't help, std::length_error is thrown
+*/
+struct RobinHoodProbing {};
+
+///Growth policy - incremental rehash
+/**
+When the map needs to grow, new table is allocated, but the entries are not moved at once.
+Every insertion moves up to `slots` slots of the old table to the new table. Lookups
+and erases consult both tables until the old table is empty. This makes latency of
+an insertion predictable.
+
+Iterators are invalidated by insertion as usual. Erase doesn't move entries between
+tables, so it is safe to erase during iteration
+@tparam slots count of slots of the old table processed per insertion (must be at least 2)
+*/
+template<std::size_t slots = 16>
+struct IncrementalRehash {
+    static_assert(slots >= 2, "Incremental rehash must process at least 2 slots per step");
+    static constexpr std::size_t step = slots;
+};
+
+///Storage policy - store full hash of each entry
+/**
+Hash of each key is stored in a parallel array. Expand, incremental rehash and
+erase use the stored hash, so the hasher is called only once per inserted key. The
+stored hash is also compared before the keys are compared. Useful for keys, which are
+expensive to hash or compare (long strings)
+*/
+struct StoreHash {};
+
+///Storage policy - keys and values are stored in separate arrays
+/**
+Probing touches only array of keys, so large values are not loaded into the cache
+during lookup. Iterators return a proxy object with members `first` and `second`,
+which are references to the key and the value.
+*/
+struct SplitKeyValue {};
+
+///Storage policy - allocator of arrays of the table
+/**
+@tparam Alloc allocator (it is rebound to types of arrays). Allocator is default constructed.
+For example AlignedAllocator<char> for cache line aligned arrays or HugePageAllocator<char>
+for very large tables (see FixSizeVector.hpp, HugePageAllocator.hpp). Default is std::allocator
+*/
+template<typename Alloc>
+struct UseAllocator {
+    using type = Alloc;
+};
+
+///Storage policy - store small tables inside of the map object
+/**
+@tparam slots tables up to this capacity are stored inline, so small maps don't allocate.
+The object of the map becomes larger. Moving of the map copies the inline table. Keys and
+values must be trivially copyable
+*/
+template<std::size_t slots>
+struct InlineStorage {
+    static constexpr std::size_t value = slots;
+};
+
+///Diagnostic policy - collect statistics
+/**
+The map counts probe lengths, expansions and entries moved during insert and erase.
+Use stats() to retrieve the statistics. Without this option, no counters are
+stored and nothing is counted. Statistics are not collected in constant evaluation
+
+Const lookups (find, contains, ...) update the counters of the object, so they
+are not thread-safe with this option, even when no thread modifies the map
+*/
+struct CollectStats {};
+
+///Statistics of the hash map (see CollectStats)
+struct HashMapStats {
+    static constexpr std::size_t histogram_size = 16;
+    ///histogram of probe lengths of lookups and insertions
+    /** probe length is distance from home slot to slot where the probe stopped. Index 0
+    counts probes of length 0, index i counts lengths in range 2^(i-1) - 2^i-1, the last
+    index counts all longer probes */
+    std::array<std::uint64_t, histogram_size> probe_histogram = {};
+    ///count of probes (lookups and insertions)
+    std::uint64_t probes = 0;
+    ///sum of all probe lengths
+    std::uint64_t probe_length_total = 0;
+    ///longest probe
+    std::uint64_t probe_length_max = 0;
+    ///count of expansions (growth of the table)
+    std::uint64_t expands = 0;
+    ///count of entries moved to fill gap after erase
+    std::uint64_t erase_moves = 0;
+    ///count of entries shifted during insertion (RobinHoodProbing)
+    std::uint64_t insert_moves = 0;
+    ///largest distance of an entry from its home slot (current table)
+    std::size_t max_displacement = 0;
+    ///mean distance of entries from their home slots (current table)
+    double mean_displacement = 0;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    float load_factor = 0;
+
+    constexpr double mean_probe_length() const {
+        return probes?static_cast<double>(probe_length_total)/static_cast<double>(probes):0.0;
+    }
+
+    ///record probe of given length
+    constexpr void record_probe(std::size_t length) {
+        ++probes;
+        probe_length_total += length;
+        probe_length_max = std::max<std::uint64_t>(probe_length_max, length);
+        ++probe_histogram[std::min<std::size_t>(std::bit_width(length), histogram_size - 1)];
+    }
+};
+
+namespace _details {
+
+struct HashMapNone {};
+
+///Result of operator-> for iterators which return proxy object
+template<typename T>
+struct HashMapArrow {
+    T ref;
+    constexpr const T *operator->() const {return &ref;}
+};
+
+template<typename Tag, typename ... Options>
+constexpr bool hash_map_has_option = (std::is_same_v<Tag, Options> || ...);
+
+template<typename ... Options>
+struct HashMapRehashStep {
+    static constexpr std::size_t value = 0;
+};
+
+template<std::size_t slots, typename ... Options>
+struct HashMapRehashStep<IncrementalRehash<slots>, Options...> {
+    static constexpr std::size_t value = slots;
+};
+
+template<typename First, typename ... Options>
+struct HashMapRehashStep<First, Options...>: HashMapRehashStep<Options...> {};
+
+template<typename ... Options>
+struct HashMapInlineSlots {
+    static constexpr std::size_t value = 0;
+};
+
+template<std::size_t slots, typename ... Options>
+struct HashMapInlineSlots<InlineStorage<slots>, Options...> {
+    static constexpr std::size_t value = slots;
+};
+
+template<typename First, typename ... Options>
+struct HashMapInlineSlots<First, Options...>: HashMapInlineSlots<Options...> {};
+
+template<typename ... Options>
+struct HashMapAllocator {
+    using type = std::allocator<char>;
+};
+
+template<typename Alloc, typename ... Options>
+struct HashMapAllocator<UseAllocator<Alloc>, Options...> {
+    using type = Alloc;
+};
+
+template<typename First, typename ... Options>
+struct HashMapAllocator<First, Options...>: HashMapAllocator<Options...> {};
+
+template<typename ... Options>
+struct HashMapCapacity {
+    using type = PrimeCapacity;
+};
+
+template<typename First, typename ... Options>
+struct HashMapCapacity<First, Options...> {
+    using type = std::conditional_t<HashMapCapacityPolicy<First>, First, typename HashMapCapacity<Options...>::type>;
+};
+
+}
+
+
+template<typename K, typename V, typename Hash, typename Equal, typename ... Options>
+class OpenHashMapView;
 
 ///Declare hash map
 /**
@@ -20,8 +383,13 @@ Hash map with open addressing constexpr testable
 @tparam V value type
 @tparam Hash hasher
 @tparam Equal comparator
+If both Hash and Equal declare `is_transparent`, lookup functions accept any key type supported
+by the hasher and the comparator (for example std::string_view for std::string keys)
+@tparam Options optional policies. Capacity policy: PrimeCapacity (default) or PowerOfTwoCapacity.
+Probing: linear probing (default) or RobinHoodProbing. Growth: rehash at once (default)
+or IncrementalRehash. Storage: StoreHash, SplitKeyValue, UseAllocator, InlineStorage. Diagnostics: CollectStats
  */
-template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K> >
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename ... Options>
 class OpenHashMap {
     
     struct KeyValue {
@@ -29,23 +397,102 @@ class OpenHashMap {
         V second;
     };
 
-    struct Item {
+    ///Reference to key and value (SplitKeyValue)
+    template<bool is_const>
+    struct KeyValueRef {
+        const K &first;
+        std::conditional_t<is_const, const V, V> &second;
+    };
+
+    ///Storage of one slot
+    template<typename T>
+    struct Slot {
         union {
-            KeyValue key_value;
+            T data;
         };
-        constexpr Item() {}
-        constexpr ~Item() {}
+        constexpr Slot() {}
+        constexpr ~Slot() {}
+
+        ///Move content to other (unused) slot and destroy content of this slot
+        /** At runtime, the key of KeyValue is moved, despite it is declared as const. This is safe
+        as the source is destroyed immediately. In constant evaluation, the key is copied */
+        constexpr void relocate_to(Slot &target) {
+            if constexpr(std::is_same_v<T, KeyValue>) {
+                if (std::is_constant_evaluated() || !std::is_move_constructible_v<K>) {
+                    std::construct_at(&target.data, std::move(data));
+                } else {
+                    std::construct_at(&target.data,
+                            std::move(const_cast<K &>(data.first)), std::move(data.second));
+                }
+            } else {
+                std::construct_at(&target.data, std::move(data));
+            }
+            std::destroy_at(&data);
+        }
+    };
+
+    static constexpr bool split = _details::hash_map_has_option<SplitKeyValue, Options...>;
+
+    static constexpr std::size_t inline_slots = _details::HashMapInlineSlots<Options...>::value;
+    static_assert(inline_slots == 0 || (std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>),
+                  "InlineStorage requires trivially copyable key and value");
+
+    template<typename T>
+    using ArrayAlloc = typename std::allocator_traits<
+                    typename _details::HashMapAllocator<Options...>::type>::template rebind_alloc<T>;
+
+    ///array of the table, allocated by allocator specified by UseAllocator
+    /** @tparam extra count of extra items of the array above capacity of the table */
+    template<typename T, std::size_t extra = 0>
+    using Array = std::conditional_t<inline_slots == 0, FixSizeVector<T, ArrayAlloc<T> >,
+                    InlineFixSizeVector<T, inline_slots + extra, ArrayAlloc<T> > >;
+    using CtrlArray = Array<std::uint8_t, _details::HashMapGroup::width>;
+
+    ///Item stored in main array (whole key-value, or key only for SplitKeyValue)
+    using Item = std::conditional_t<split, Slot<K>, Slot<KeyValue> >;
+    ///Item stored in array of values (SplitKeyValue)
+    using ValueItem = Slot<V>;
+
+    template<bool is_const>
+    using Ref = std::conditional_t<split, KeyValueRef<is_const>,
+                    std::conditional_t<is_const, const KeyValue &, KeyValue &> >;
+
+    static constexpr bool robin_hood = _details::hash_map_has_option<RobinHoodProbing, Options...>;
+    static constexpr std::size_t rehash_step = _details::HashMapRehashStep<Options...>::value;
+    static constexpr bool incremental = rehash_step > 0;
+    static constexpr bool store_hash = _details::hash_map_has_option<StoreHash, Options...>;
+    static constexpr bool collect_stats = _details::hash_map_has_option<CollectStats, Options...>;
+    static constexpr bool transparent = requires {
+        typename Hash::is_transparent;
+        typename Equal::is_transparent;
+    };
+    template<typename Key>
+    static constexpr bool lookup_key = transparent || std::is_same_v<std::remove_cvref_t<Key>, K>;
+
+    ///old table during incremental rehash
+    struct OldTable {
+        OpenHashMap *map = nullptr;
+        ///next slot of old table to migrate
+        std::size_t pos = 0;
     };
 
+    ///reads internal layout to write and read binary image (OpenHashMapView.hpp)
+    template<typename, typename, typename, typename, typename ...>
+    friend class OpenHashMapView;
+
 public:
 
     constexpr OpenHashMap() = default;
     constexpr OpenHashMap(std::size_t size, Hash hasher = {}, Equal equal = {})
         :_hasher(std::move(hasher))
         ,_eq(std::move(equal))
-        ,_items(size)
-        ,_stateb(initStateArray(size))
+        ,_items(Capacity::initial_capacity(size))
+        ,_ctrl(init_ctrl_array(_items.size()))
+        ,_values(init_value_array(_items.size()))
+        ,_dist(init_dist_array(_items.size()))
+        ,_hashes(init_hash_array(_items.size()))
         ,_size(0)
+        ,_grow_at(grow_threshold(_items.size()))
         {
         }
     
@@ -53,7 +500,9 @@ public:
     constexpr ~OpenHashMap() {
         clear();
     }
-    constexpr OpenHashMap(const OpenHashMap &other):OpenHashMap(other.size(), other._hasher, other._eq) {
+    constexpr OpenHashMap(const OpenHashMap &other):OpenHashMap(0, other._hasher, other._eq) {
+        _max_load_factor = other._max_load_factor;
+        reserve(other.size());
         for (const auto &[k, v]: other) {
             emplace(k, v);
         }
@@ -62,7 +511,9 @@ public:
         if (this != &other) {
             clear();
             _hasher = other._hasher;
-            _eq = other._eq;                
+            _eq = other._eq;
+            _max_load_factor = other._max_load_factor;
+            reserve(other.size());
             for (const auto &[k, v]: other) {
                 emplace(k, v);
             }
@@ -73,9 +524,18 @@ public:
         :_hasher(std::move(other._hasher))
         ,_eq(std::move(other._eq))
         ,_items(std::move(other._items))
-        ,_stateb(std::move(other._stateb))
-        ,_size(std::move(other._size)) {
+        ,_ctrl(std::move(other._ctrl))
+        ,_values(std::move(other._values))
+        ,_dist(std::move(other._dist))
+        ,_hashes(std::move(other._hashes))
+        ,_old(std::move(other._old))
+        ,_size(std::move(other._size))
+        ,_max_load_factor(other._max_load_factor)
+        ,_grow_at(other._grow_at) {
+            move_stats(other);
             other._size = 0;
+            other._grow_at = 0;
+            if constexpr(incremental) other._old.map = nullptr;
         }
     constexpr OpenHashMap &operator=(OpenHashMap &&other) {
         if (this != &other) {
@@ -83,9 +543,18 @@ public:
             _hasher = std::move(other._hasher);
             _eq = std::move(other._eq);
             _items = std::move(other._items);
-            _stateb = std::move(other._stateb);
+            _ctrl = std::move(other._ctrl);
+            _values = std::move(other._values);
+            _dist = std::move(other._dist);
+            _hashes = std::move(other._hashes);
+            _old = std::move(other._old);
             _size = std::move(other._size);
+            _max_load_factor = other._max_load_factor;
+            _grow_at = other._grow_at;
+            move_stats(other);
             other._size = 0;
+            other._grow_at = 0;
+            if constexpr(incremental) other._old.map = nullptr;
         }
         return *this;
     }
@@ -96,35 +565,41 @@ public:
     public:
         using iterator_concept  = std::bidirectional_iterator_tag;
         using iterator_category = std::bidirectional_iterator_tag;
-        using value_type        = std::conditional_t<is_const,const KeyValue, KeyValue >;
+        using value_type        = std::conditional_t<split, KeyValueRef<is_const>,
+                                        std::conditional_t<is_const,const KeyValue, KeyValue > >;
         using difference_type   = std::ptrdiff_t;
-        using pointer           = value_type *;
-        using reference         = value_type &;
+        using reference         = Ref<is_const>;
+        using pointer           = std::conditional_t<split, _details::HashMapArrow<value_type>, value_type *>;
         using owner             = std::conditional_t<is_const,const OpenHashMap *, OpenHashMap *>;
         
         constexpr iterator_base(owner own, std::size_t ofs):_owner(own), _offset(ofs) {}
 
 
-        constexpr value_type & operator*() const {
-            return _owner->_items[_offset].key_value;
+        constexpr reference operator*() const {
+            return _owner->ref_at(_offset);
         }
-        constexpr value_type * operator->() const {
-            return &_owner->_items[_offset].key_value;
+        constexpr pointer operator->() const {
+            if constexpr(split) {
+                return pointer{_owner->ref_at(_offset)};
+            } else {
+                return &_owner->ref_at(_offset);
+            }
         }
         constexpr bool operator==(const iterator_base &other) const {
             return _owner == other._owner && _offset == other._offset;
         }
         constexpr iterator_base & operator++() {
+            auto cnt = _owner->slot_count();
             do {
                 ++_offset;
-            } while (!_owner->is_occupied(_offset));
+            } while (_offset < cnt && !_owner->is_occupied_at(_offset));
             return *this;
         }   
 
         constexpr iterator_base & operator--() {
             do {
                 --_offset;
-            } while (_offset > 0 && !_owner->is_occupied(_offset));
+            } while (_offset > 0 && !_owner->is_occupied_at(_offset));
             return *this;
         }   
 
@@ -154,29 +629,20 @@ public:
     using iterator = iterator_base<false>;
     using const_iterator = iterator_base<true>;
 
+    ///Insert new item, if key doesn't exist
+    /**
+    @param key key. If hasher and comparator are not transparent, the key is converted to K
+    before lookup. Otherwise the key is converted to K only when the item is inserted
+    @param args arguments to construct value
+    @return pair of iterator and bool, which is true, if the item was inserted
+     */
     template<typename Key, typename ... Args>
     constexpr auto try_emplace(Key &&key, Args && ... args) {
-        if ((_items.size()*3/5) <= size()) {
-            expand();
+        if constexpr(!transparent && !std::is_same_v<std::remove_cvref_t<Key>, K>) {
+            return try_emplace(K(std::forward<Key>(key)), std::forward<Args>(args)...);
+        } else {
+            return emplace_hashed(hash_key(key), std::forward<Key>(key), std::forward<Args>(args)...);
         }
-        auto idx = map_key(key);            
-        auto start = idx;            
-        do {
-            if (is_occupied(idx)) {
-                if (_eq(_items[idx].key_value.first, key)) {
-                    return std::pair(iterator(this, idx), false);
-                }
-            } else {
-                std::construct_at(&_items[idx].key_value, std::move(key), V(std::forward<Args>(args)...));
-                set_occupied(idx);
-                ++_size;
-                return std::pair(iterator(this, idx), true);
-            }
-            idx = (idx+1) % _items.size();
-        } while (idx != start);
-        //unreachable code
-        return std::pair(end(), false);
-
     }
 
     template<typename Key, typename... Args>
@@ -184,24 +650,42 @@ public:
         return try_emplace(std::forward<Key>(key), std::forward<Args>(args)...);
     }
 
+    ///Insert new item with precalculated hash, if key doesn't exist
+    /**
+    @param hash result of hash_function() for the key
+    @param key key
+    @param args arguments to construct value
+    @return pair of iterator and bool, which is true, if the item was inserted
+     */
+    template<typename Key, typename ... Args>
+    constexpr auto try_emplace_hashed(std::size_t hash, Key &&key, Args && ... args) {
+        if constexpr(!transparent && !std::is_same_v<std::remove_cvref_t<Key>, K>) {
+            return try_emplace_hashed(hash, K(std::forward<Key>(key)), std::forward<Args>(args)...);
+        } else {
+            return emplace_hashed(mix_hash(hash), std::forward<Key>(key), std::forward<Args>(args)...);
+        }
+    }
+
     constexpr iterator begin() {
         std::size_t idx = 0;
-        while (idx < _items.size() && !is_occupied(idx)) ++idx;
+        std::size_t cnt = slot_count();
+        while (idx < cnt && !is_occupied_at(idx)) ++idx;
         return iterator(this, idx);
     }
 
     constexpr iterator end() {
-        return iterator(this, _items.size());
+        return iterator(this, slot_count());
     }
 
     constexpr const_iterator begin() const {
         std::size_t idx = 0;
-        while (idx < _items.size() && !is_occupied(idx)) ++idx;
+        std::size_t cnt = slot_count();
+        while (idx < cnt && !is_occupied_at(idx)) ++idx;
         return const_iterator(this, idx);
     }
 
     constexpr const_iterator end() const {
-        return const_iterator(this, _items.size());
+        return const_iterator(this, slot_count());
     }
 
     constexpr std::size_t size() const {
@@ -212,46 +696,261 @@ public:
         return _items.size();
     }
 
+    constexpr float load_factor() const {
+        return _items.empty()?0.0f:static_cast<float>(_size) / static_cast<float>(_items.size());
+    }
+
+    constexpr float max_load_factor() const {
+        return _max_load_factor;
+    }
+
+    ///Set maximum load factor
+    /**
+    @param ml new maximum load factor. The value is clamped to range 0.1 - 0.95. Default is 0.6.
+    The table is not rehashed, unless it exceeds new load factor. To release memory
+    after the load factor was increased, call shrink_to_fit()
+     */
+    constexpr void max_load_factor(float ml) {
+        _max_load_factor = std::clamp(ml, 0.1f, 0.95f);
+        _grow_at = grow_threshold(_items.size());
+        if (_size >= _grow_at && _size) resize(required_capacity(_size));
+    }
+
+    ///Prepare table for given count of entries
+    /**
+    Allocates table at once, so no expansion happens until the count of entries
+    exceeds the given count. If the table is already large enough, nothing happens
+    @param count count of entries
+     */
+    constexpr void reserve(std::size_t count) {
+        auto cap = required_capacity(count);
+        if (cap > _items.size()) resize(cap);
+    }
+
+    ///Rebuild the table with given capacity
+    /**
+    @param count requested capacity. The capacity is never less than capacity required
+    for current count of entries. Use 0 to rebuild table with minimal capacity.
+     */
+    constexpr void rehash(std::size_t count) {
+        auto cap = std::max(Capacity::initial_capacity(count), required_capacity(_size));
+        if (cap != _items.size()) resize(cap);
+    }
+
+    ///Release unused memory (rehash to minimal capacity)
+    constexpr void shrink_to_fit() {
+        rehash(0);
+    }
+
+    ///Retrieve statistics (CollectStats)
+    /** Counters are accumulated since construction or reset_stats(). Displacement and
+    load factor are calculated from current content of the table (it scans the table) */
+    HashMapStats stats() const requires(collect_stats) {
+        HashMapStats out = _stats;
+        std::size_t cap = _items.size();
+        std::size_t total = 0;
+        std::size_t cnt = 0;
+        for (std::size_t i = 0; i < cap; ++i) {
+            if (!is_occupied(i)) continue;
+            std::size_t d;
+            if constexpr(robin_hood) d = _dist[i];
+            else d = (i + cap - home_index(hash_at(i))) % cap;
+            out.max_displacement = std::max(out.max_displacement, d);
+            total += d;
+            ++cnt;
+        }
+        out.mean_displacement = cnt?static_cast<double>(total)/static_cast<double>(cnt):0.0;
+        out.size = _size;
+        out.capacity = cap;
+        out.load_factor = load_factor();
+        return out;
+    }
+
+    ///Reset counters of statistics (CollectStats)
+    void reset_stats() requires(collect_stats) {
+        _stats = {};
+    }
+
+    ///Returns hasher
+    /** You can use hasher to calculate hash of a key once and use the hash to search
+    the key in multiple maps which share the same hasher */
+    constexpr const Hash &hash_function() const {
+        return _hasher;
+    }
+
+    ///Returns comparator
+    constexpr const Equal &key_eq() const {
+        return _eq;
+    }
+
     constexpr iterator find(const K &key) {
-        auto idx = find_index(key);
-        if (idx == std::size_t(-1)) return end();
-        return iterator(this, idx);
+        return make_iterator(find_index(key, hash_key(key)));
     }
 
     constexpr const_iterator find(const K &key) const {
-        auto idx = find_index(key);
-        if (idx == std::size_t(-1)) return end();
-        return const_iterator(this, idx);
+        return make_iterator(find_index(key, hash_key(key)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr iterator find(const Key &key) {
+        return make_iterator(find_index(key, hash_key(key)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key) const {
+        return make_iterator(find_index(key, hash_key(key)));
+    }
+
+    ///Find key using precalculated hash
+    /**
+    @param key key to find
+    @param hash hash of the key calculated by hash_function()
+    @return iterator
+     */
+    constexpr iterator find(const K &key, std::size_t hash) {
+        return make_iterator(find_index(key, mix_hash(hash)));
+    }
+
+    constexpr const_iterator find(const K &key, std::size_t hash) const {
+        return make_iterator(find_index(key, mix_hash(hash)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr iterator find(const Key &key, std::size_t hash) {
+        return make_iterator(find_index(key, mix_hash(hash)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key, std::size_t hash) const {
+        return make_iterator(find_index(key, mix_hash(hash)));
     }
 
+    ///Find multiple keys at once
+    /**
+    Keys are processed in batches. Hashes of all keys of the batch are calculated and
+    their home slots are prefetched first, then the keys are resolved. This hides memory
+    latency for tables which don't fit into the cache.
+
+    @param keys range of keys
+    @param out output iterator, receives iterator for each key (end() if not found)
+    @return output iterator after last written item
+     */
+    template<std::ranges::forward_range Keys, std::output_iterator<iterator> OutIter>
+    requires(lookup_key<std::ranges::range_value_t<Keys> >)
+    constexpr OutIter find_many(const Keys &keys, OutIter out) {
+        lookup_many(keys, [&](std::size_t idx) {*out = make_iterator(idx); ++out;});
+        return out;
+    }
+
+    template<std::ranges::forward_range Keys, std::output_iterator<const_iterator> OutIter>
+    requires(lookup_key<std::ranges::range_value_t<Keys> >)
+    constexpr OutIter find_many(const Keys &keys, OutIter out) const {
+        lookup_many(keys, [&](std::size_t idx) {*out = make_iterator(idx); ++out;});
+        return out;
+    }
+
+    ///Test presence of multiple keys at once (see find_many())
+    /**
+    @param keys range of keys
+    @param out output iterator, receives bool for each key
+    @return output iterator after last written item
+     */
+    template<std::ranges::forward_range Keys, std::output_iterator<bool> OutIter>
+    requires(lookup_key<std::ranges::range_value_t<Keys> >)
+    constexpr OutIter contains_many(const Keys &keys, OutIter out) const {
+        lookup_many(keys, [&](std::size_t idx) {*out = idx != std::size_t(-1); ++out;});
+        return out;
+    }
+
+    constexpr bool contains(const K &key) const {
+        return find_index(key, hash_key(key)) != std::size_t(-1);
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr bool contains(const Key &key) const {
+        return find_index(key, hash_key(key)) != std::size_t(-1);
+    }
+
+    ///Test presence of the key using precalculated hash (see find())
+    constexpr bool contains(const K &key, std::size_t hash) const {
+        return find_index(key, mix_hash(hash)) != std::size_t(-1);
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr bool contains(const Key &key, std::size_t hash) const {
+        return find_index(key, mix_hash(hash)) != std::size_t(-1);
+    }
+
+    ///Erase item at iterator
+    /**
+    @param it iterator
+    @return iterator to next item. Note that erase can move an item from next slot to
+    the erased slot, so returned iterator can refer to the same slot
+     */
     template<bool is_const>
     constexpr iterator_base<is_const> erase(iterator_base<is_const> it) {
         auto idx = it._offset;
         erase_index(idx);
-        return ++it;
+        if (!is_occupied_at(idx)) ++it;
+        return it;
     }
 
     constexpr void erase(const K &key) {
-        auto idx = find_index(key);
+        auto idx = find_index(key, hash_key(key));
+        if (idx != std::size_t(-1)) {
+            erase_index(idx);
+        }
+    }
+
+    template<typename Key>
+    requires(transparent && !std::is_convertible_v<Key, const_iterator>)
+    constexpr void erase(const Key &key) {
+        auto idx = find_index(key, hash_key(key));
+        if (idx != std::size_t(-1)) {
+            erase_index(idx);
+        }
+    }
+
+    ///Erase with precalculated hash (result of hash_function())
+    constexpr void erase(const K &key, std::size_t hash) {
+        auto idx = find_index(key, mix_hash(hash));
+        if (idx != std::size_t(-1)) {
+            erase_index(idx);
+        }
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr void erase(const Key &key, std::size_t hash) {
+        auto idx = find_index(key, mix_hash(hash));
         if (idx != std::size_t(-1)) {
             erase_index(idx);
         }
     }
 
     constexpr void clear() {
-        std::size_t ofs = 0;
-        for (auto &item: _items) { 
+        if constexpr(incremental) {
+            delete _old.map;
+            _old = {};
+        }
+        std::size_t cnt = _items.size();
+        for (std::size_t ofs = 0; ofs < cnt; ++ofs) {
             if (is_occupied(ofs)) {
-                    std::destroy_at(&item.key_value);
-                    set_not_occupied(ofs);
+                destroy_slot(ofs);
+                set_not_occupied(ofs);
             }
-            ++ofs;
-        }    
+        }
         _size = 0;
     }
 
     constexpr V& operator[](const K &key) {
-        auto res = try_emplace(key, V{});
+        auto res = try_emplace(key);
         return res.first->second;
     }
 
@@ -261,111 +960,566 @@ protected:
     [[no_unique_address]] Hash _hasher = {};
     [[no_unique_address]] Equal _eq = {};
 
-    FixSizeVector<Item> _items;
-    FixSizeVector<std::uint8_t> _stateb;
+    using Group = _details::HashMapGroup;
+    using Capacity = typename _details::HashMapCapacity<Options...>::type;
+
+    Array<Item> _items;
+    ///control bytes, one per slot, padded by one group
+    CtrlArray _ctrl;
+    ///values (only for SplitKeyValue)
+    [[no_unique_address]] std::conditional_t<split, Array<ValueItem>, _details::HashMapNone> _values;
+    ///distances from home slot (only for RobinHoodProbing)
+    [[no_unique_address]] std::conditional_t<robin_hood, Array<std::uint8_t>, _details::HashMapNone> _dist;
+    ///stored hashes (only for StoreHash)
+    [[no_unique_address]] std::conditional_t<store_hash, Array<std::size_t>, _details::HashMapNone> _hashes;
+    ///old table (only for IncrementalRehash)
+    [[no_unique_address]] std::conditional_t<incremental, OldTable, _details::HashMapNone> _old;
     std::size_t _size = 0;
+    float _max_load_factor = 0.6f;
+    ///count of entries, when table must grow
+    std::size_t _grow_at = 0;
+    ///statistics (only for CollectStats), updated also by const lookups (not thread-safe)
+    [[no_unique_address]] mutable std::conditional_t<collect_stats, HashMapStats, _details::HashMapNone> _stats;
 
-    static constexpr std::array<size_t, 28> prime_sizes = {
-        5ul, 11ul, 23ul, 47ul, 97ul, 197ul, 397ul,
-        797ul, 1597ul, 3203ul, 6421ul, 12853ul, 25717ul,
-        51437ul, 102877ul, 205759ul, 411527ul, 823117ul,
-        1646237ul, 3292489ul, 6584983ul, 13169977ul,
-        26339969ul, 52679969ul, 105359939ul, 210719881ul,
-        421439783ul, 842879579ul
+    ///Increment counter of statistics (CollectStats)
+    /** Lookups of a constexpr map are constant expressions only if they don't modify the
+    map (mutable member of an object created outside of the evaluation can't be modified),
+    so statistics are collected at runtime only */
+    constexpr void count_stat(std::uint64_t HashMapStats::*counter) const {
+        if constexpr(collect_stats) {
+            if (!std::is_constant_evaluated()) ++(_stats.*counter);
+        }
+    }
+
+    constexpr void count_probe(std::size_t length) const {
+        if constexpr(collect_stats) {
+            if (!std::is_constant_evaluated()) _stats.record_probe(length);
+        }
+    }
+
+    constexpr void move_stats(OpenHashMap &other) {
+        if constexpr(collect_stats) {
+            if (!std::is_constant_evaluated()) {
+                _stats = other._stats;
+                other._stats = {};
+            }
+        }
+    }
+
+    static constexpr std::size_t max_distance = 255;
+
+    struct ProbeResult {
+        ///index of found item, or index where item can be inserted, or -1 if map is full
+        std::size_t index;
+        ///distance of index from home slot
+        std::size_t distance;
+        ///true if key was found
+        bool found;
     };
 
-    static constexpr size_t next_capacity(size_t current) {
-        for (size_t p : prime_sizes)
-            if (p > current) return p;
-        return current * 2 + 1; 
+    template<typename Key>
+    constexpr std::size_t hash_key(const Key &k) const {
+        return mix_hash(_hasher(k));
     }
 
+    ///improve quality of the hash, as std::hash is often identity
+    static constexpr std::size_t mix_hash(std::size_t hash) {
+        return _details::hash_map_mix(hash);
+    }
+
+    ///7 bit fingerprint stored in control byte (uses highest bits of the hash)
+    static constexpr std::uint8_t fingerprint(std::size_t hash) {
+        return static_cast<std::uint8_t>(hash >> (sizeof(std::size_t) * 8 - 7));
+    }
+
+    constexpr std::size_t home_index(std::size_t hash) const {
+        return Capacity::home_index(hash, _items.size());
+    }
 
     constexpr std::size_t map_key(const K &k) const {
-        std::size_t hash = _hasher(k);
-        if constexpr(sizeof(std::size_t) == 4) {
-            constexpr uint32_t multiplier = 2654435761U;
-            hash ^= (hash >> 5) ^ (hash << 7);
-            hash *= multiplier;
+        return home_index(hash_key(k));
+    }
+
+    constexpr void expand() {
+        count_stat(&HashMapStats::expands);
+        auto newsz = Capacity::next_capacity(_items.size());
+        if constexpr(incremental) {
+            if (_old.map) migrate(std::size_t(-1));
+            if (_size) {
+                auto old = new OpenHashMap(0, _hasher, _eq);
+                move_table_to(*old);
+                _old.map = old;
+                _old.pos = 0;
+            }
+            allocate_table(newsz);
+            return;
+        }
+        resize(newsz);
+    }
+
+    ///Rebuild table with new capacity at once
+    constexpr void resize(std::size_t newsz) {
+        if constexpr(incremental) {
+            if (_old.map) migrate(std::size_t(-1));
+        }
+        OpenHashMap old(0, _hasher, _eq);
+        move_table_to(old);
+        allocate_table(newsz);
+        auto oldcap = old._items.size();
+        for (std::size_t i = 0; i < oldcap; ++i) {
+            if (old.is_occupied(i)) {
+                insert_unique(old.hash_at(i), old, i);
+                old.set_not_occupied(i);
+            }
+        }
+    }
+
+    ///Move arrays of the table to other instance (and set its size)
+    constexpr void move_table_to(OpenHashMap &target) {
+        target._items = std::move(_items);
+        target._ctrl = std::move(_ctrl);
+        target._values = std::move(_values);
+        target._dist = std::move(_dist);
+        target._hashes = std::move(_hashes);
+        target._size = _size;
+    }
+
+    ///Allocate empty arrays of the table
+    constexpr void allocate_table(std::size_t count) {
+        _items = Array<Item>(count);
+        _ctrl = init_ctrl_array(count);
+        _values = init_value_array(count);
+        _dist = init_dist_array(count);
+        _hashes = init_hash_array(count);
+        _grow_at = grow_threshold(count);
+    }
+
+    ///count of entries, when table must grow
+    /** at least one slot must always be empty */
+    constexpr std::size_t grow_threshold(std::size_t count) const {
+        if (count == 0) return 0;
+        auto r = static_cast<std::size_t>(static_cast<double>(count) * _max_load_factor);
+        return std::min(r, count - 1);
+    }
+
+    ///minimal capacity to hold given count of entries
+    constexpr std::size_t required_capacity(std::size_t count) const {
+        if (count == 0) return 0;
+        auto r = static_cast<std::size_t>(static_cast<double>(count) / _max_load_factor) + 1;
+        return Capacity::initial_capacity(r);
+    }
+
+    ///Insert new item using precalculated hash
+    template<typename Key, typename ... Args>
+    constexpr std::pair<iterator, bool> emplace_hashed(std::size_t hash, Key &&key, Args && ... args) {
+        if constexpr(incremental) {
+            if (_old.map) migrate(rehash_step);
+        }
+        if (_size >= _grow_at) {
+            expand();
+        }
+        auto h2 = fingerprint(hash);
+        auto r = probe(hash, h2, key);
+        count_probe(r.distance);
+        if (r.found) {
+            return std::pair(iterator(this, r.index), false);
+        }
+        if constexpr(incremental) {
+            if (_old.map) {
+                auto o = _old.map->probe(hash, h2, key);
+                if (o.found) return std::pair(iterator(this, _items.size() + o.index), false);
+            }
+        }
+        if constexpr(robin_hood) {
+            if (!make_room(r.index, r.distance)) {
+                expand();
+                r = probe(hash, h2, key);
+                if (!make_room(r.index, r.distance)) {
+                    throw std::length_error("OpenHashMap: probe distance overflow");
+                }
+            }
+            _dist[r.index] = static_cast<std::uint8_t>(r.distance);
+        }
+        construct_slot(r.index, std::forward<Key>(key), std::forward<Args>(args)...);
+        _ctrl[r.index] = h2;
+        if constexpr(store_hash) _hashes[r.index] = hash;
+        ++_size;
+        return std::pair(iterator(this, r.index), true);
+    }
+
+    static constexpr std::size_t lookup_batch = 16;
+
+    ///Process lookups in batches with prefetch
+    /**
+    @param keys keys
+    @param fn function receives result of find_index() for each key
+     */
+    template<typename Keys, typename Fn>
+    constexpr void lookup_many(const Keys &keys, Fn &&fn) const {
+        std::array<std::size_t, lookup_batch> hashes = {};
+        auto iter = std::ranges::begin(keys);
+        auto end = std::ranges::end(keys);
+        while (iter != end) {
+            auto batch = iter;
+            std::size_t cnt = 0;
+            while (cnt < lookup_batch && iter != end) {
+                auto hash = hash_key(*iter);
+                hashes[cnt++] = hash;
+                if (!_items.empty()) {
+                    auto home = home_index(hash);
+                    _details::hash_map_prefetch(_ctrl.data() + home);
+                    _details::hash_map_prefetch(_items.data() + home);
+                }
+                ++iter;
+            }
+            for (std::size_t i = 0; i < cnt; ++i, ++batch) {
+                fn(find_index(*batch, hashes[i]));
+            }
+        }
+    }
+
+    constexpr iterator make_iterator(std::size_t idx) {
+        return idx == std::size_t(-1)?end():iterator(this, idx);
+    }
+
+    constexpr const_iterator make_iterator(std::size_t idx) const {
+        return idx == std::size_t(-1)?end():const_iterator(this, idx);
+    }
+
+    ///hash of the key at given slot (stored or calculated)
+    constexpr std::size_t hash_at(std::size_t idx) const {
+        if constexpr(store_hash) {
+            return _hashes[idx];
         } else {
-            constexpr uint64_t multiplier = 11400714819323198485ULL;
-            hash ^= (hash >> 7) ^ (hash << 11);
-            hash *= multiplier;
+            return hash_key(key_at(idx));
         }
-        return hash % _items.size();
     }
 
-    constexpr void expand() {
-        auto newsz = next_capacity(_items.size());
-        OpenHashMap newMap(newsz, std::move(_hasher), std::move(_eq));
-        for (auto &kv : *this) {
-            newMap.try_emplace(std::move(kv.first), std::move(kv.second));
-        }            
-        *this = std::move(newMap);
+    ///Move entry to another (unused) slot
+    /** @note distance (Robin Hood) is not updated */
+    constexpr void relocate_slot(std::size_t from, std::size_t to) {
+        _items[from].relocate_to(_items[to]);
+        if constexpr(split) _values[from].relocate_to(_values[to]);
+        _ctrl[to] = _ctrl[from];
+        if constexpr(store_hash) _hashes[to] = _hashes[from];
     }
 
     constexpr bool is_occupied(std::size_t idx) const {
-        return (_stateb[idx >> 3] & (1<<(idx & 7))) != 0;
+        return (_ctrl[idx] & Group::empty) == 0;
+    }
+
+    ///count of slots visible to iterators (slots of old table follows slots of current table)
+    constexpr std::size_t slot_count() const {
+        if constexpr(incremental) {
+            if (_old.map) return _items.size() + _old.map->_items.size();
+        }
+        return _items.size();
+    }
+
+    constexpr bool is_occupied_at(std::size_t idx) const {
+        if constexpr(incremental) {
+            if (idx >= _items.size()) return _old.map->is_occupied(idx - _items.size());
+        }
+        return is_occupied(idx);
+    }
+
+    constexpr const K &key_at(std::size_t idx) const {
+        if constexpr(split) {
+            return _items[idx].data;
+        } else {
+            return _items[idx].data.first;
+        }
     }
 
-    constexpr void set_occupied(std::size_t idx) {
-        _stateb[idx >> 3] |= (1 << (idx & 7));
+    ///reference to key-value of slot for iterators (includes slots of old table)
+    constexpr Ref<false> ref_at(std::size_t idx) {
+        if constexpr(incremental) {
+            if (idx >= _items.size()) return _old.map->ref_at(idx - _items.size());
+        }
+        if constexpr(split) {
+            return {_items[idx].data, _values[idx].data};
+        } else {
+            return _items[idx].data;
+        }
+    }
+
+    constexpr Ref<true> ref_at(std::size_t idx) const {
+        if constexpr(incremental) {
+            if (idx >= _items.size()) return std::as_const(*_old.map).ref_at(idx - _items.size());
+        }
+        if constexpr(split) {
+            return {_items[idx].data, _values[idx].data};
+        } else {
+            return _items[idx].data;
+        }
+    }
+
+    template<typename Key, typename ... Args>
+    constexpr void construct_slot(std::size_t idx, Key &&key, Args && ... args) {
+        if constexpr(split) {
+            std::construct_at(&_items[idx].data, std::forward<Key>(key));
+            try {
+                std::construct_at(&_values[idx].data, std::forward<Args>(args)...);
+            } catch (...) {
+                std::destroy_at(&_items[idx].data);
+                throw;
+            }
+        } else if constexpr(std::is_same_v<std::remove_cvref_t<Key>, K>) {
+            std::construct_at(&_items[idx].data, std::forward<Key>(key), V(std::forward<Args>(args)...));
+        } else {
+            std::construct_at(&_items[idx].data, K(std::forward<Key>(key)), V(std::forward<Args>(args)...));
+        }
+    }
+
+    constexpr void destroy_slot(std::size_t idx) {
+        std::destroy_at(&_items[idx].data);
+        if constexpr(split) std::destroy_at(&_values[idx].data);
     }
 
     constexpr void set_not_occupied(std::size_t idx) {
-        _stateb[idx >> 3] &= ~(1 << (idx & 7));
+        _ctrl[idx] = Group::empty;
     }
 
-    constexpr std::size_t find_index(const K &key) const {
-        if (_items.size() == 0) return std::size_t(-1);
-        auto idx = map_key(key);
-        auto start = idx;
-        do {
-            if (is_occupied(idx)) {
-                if (_eq(_items[idx].key_value.first, key)) {
-                    return idx;
+    ///Walk probe sequence of the key group by group
+    /**
+    @param hash hash of the key
+    @param h2 fingerprint of the key
+    @param key key. Use nullptr to skip comparison of keys (to find free slot only)
+    @return result of the probe. If the key was not found, the result contains position,
+    where the key should be inserted
+     */
+    template<typename Key>
+    constexpr ProbeResult probe(std::size_t hash, std::uint8_t h2, const Key &key) const {
+        const std::size_t cap = _items.size();
+        std::size_t pos = home_index(hash);
+        std::size_t dist = 0;
+        while (dist < cap) {
+            std::size_t cnt = std::min(cap - pos, std::min(cap - dist, Group::width));
+            const std::uint8_t *ctrl = _ctrl.data() + pos;
+            auto valid = Group::prefix(cnt);
+            auto empty = Group::match_empty(ctrl) & valid;
+            if constexpr(!std::is_null_pointer_v<Key>) {
+                auto match = Group::match(ctrl, h2) & valid & ((empty & (~empty + 1)) - 1);
+                while (match) {
+                    std::size_t i = Group::index(match);
+                    bool candidate = true;
+                    if constexpr(store_hash) candidate = _hashes[pos + i] == hash;
+                    if (candidate && _eq(key_at(pos + i), key)) return {pos + i, dist + i, true};
+                    match &= match - 1;
+                }
+            }
+            if constexpr(robin_hood) {
+                //distances in a cluster increase at most by one per slot, while the probe
+                //distance increases exactly by one. If the distance in the last slot of the group
+                //is not less than the distance of the probe, the same holds for all slots before
+                if (empty || _dist[pos + cnt - 1] < dist + cnt - 1) {
+                    std::size_t i = 0;
+                    while (is_occupied(pos + i) && _dist[pos + i] >= dist + i) ++i;
+                    return {pos + i, dist + i, false};
                 }
             } else {
-                break;
+                if (empty) {
+                    std::size_t i = Group::index(empty);
+                    return {pos + i, dist + i, false};
+                }
+            }
+            dist += cnt;
+            pos += cnt;
+            if (pos == cap) pos = 0;
+        }
+        return {std::size_t(-1), 0, false};
+    }
+
+    constexpr std::size_t next_index(std::size_t idx) const {
+        return ++idx == _items.size()?0:idx;
+    }
+
+    constexpr std::size_t prev_index(std::size_t idx) const {
+        return (idx?idx:_items.size()) - 1;
+    }
+
+    ///Robin Hood - shift entries of the cluster from given index to make room for new entry
+    /**
+    @param idx index where new entry will be placed
+    @param distance distance of new entry
+    @retval true success, slot at idx is free
+    @retval false distance overflow, nothing changed
+     */
+    constexpr bool make_room(std::size_t idx, std::size_t distance) {
+        if (distance > max_distance) return false;
+        std::size_t end = idx;
+        while (is_occupied(end)) {
+            if (_dist[end] == max_distance) return false;
+            end = next_index(end);
+        }
+        while (end != idx) {
+            auto src = prev_index(end);
+            relocate_slot(src, end);
+            count_stat(&HashMapStats::insert_moves);
+            _dist[end] = static_cast<std::uint8_t>(_dist[src] + 1);
+            end = src;
+        }
+        set_not_occupied(idx);
+        return true;
+    }
+
+    ///Robin Hood - backward-shift deletion
+    /** moves entries following the erased slot one slot back until an empty slot
+    or an entry at its home slot is reached */
+    constexpr void shift_back(std::size_t idx) {
+        auto next = next_index(idx);
+        while (is_occupied(next) && _dist[next] > 0) {
+            relocate_slot(next, idx);
+            count_stat(&HashMapStats::erase_moves);
+            _dist[idx] = static_cast<std::uint8_t>(_dist[next] - 1);
+            set_not_occupied(next);
+            idx = next;
+            next = next_index(idx);
+        }
+    }
+
+    ///Insert entry, which is known to be not in the table
+    /**
+    @param hash hash of the key
+    @param src table, which contains the entry (other than this)
+    @param src_idx index of the slot in the source table. The entry is relocated
+    into this table, the slot of the source table is left unoccupied, but its control
+    byte is not changed
+     */
+    constexpr void insert_unique(std::size_t hash, OpenHashMap &src, std::size_t src_idx) {
+        auto r = probe(hash, 0, nullptr);
+        if constexpr(robin_hood) {
+            if (!make_room(r.index, r.distance)) {
+                throw std::length_error("OpenHashMap: probe distance overflow");
+            }
+            _dist[r.index] = static_cast<std::uint8_t>(r.distance);
+        }
+        src._items[src_idx].relocate_to(_items[r.index]);
+        if constexpr(split) src._values[src_idx].relocate_to(_values[r.index]);
+        _ctrl[r.index] = fingerprint(hash);
+        if constexpr(store_hash) _hashes[r.index] = hash;
+    }
+
+    ///Incremental rehash - move entries from old table
+    /**
+    @param count count of slots of old table to process. The old table is released when
+    all its slots are processed
+     */
+    constexpr void migrate(std::size_t count) {
+        auto &old = *_old.map;
+        auto oldcap = old._items.size();
+        while (count && _old.pos < oldcap) {
+            auto idx = _old.pos++;
+            if (old.is_occupied(idx)) {
+                insert_unique(old.hash_at(idx), old, idx);
+                old._ctrl[idx] = Group::deleted;
+                --old._size;
+            }
+            --count;
+        }
+        if (_old.pos == oldcap) {
+            delete _old.map;
+            _old = {};
+        }
+    }
+
+    ///Find key
+    /**
+    @param key key
+    @param hash hash of the key (mixed)
+    @return index of the slot, or -1 if not found. During incremental rehash, slots
+    of the old table are indexed after slots of current table */
+    template<typename Key>
+    constexpr std::size_t find_index(const Key &key, std::size_t hash) const {
+        if (_items.size() == 0) return std::size_t(-1);
+        auto h2 = fingerprint(hash);
+        auto r = probe(hash, h2, key);
+        count_probe(r.distance);
+        if (r.found) return r.index;
+        if constexpr(incremental) {
+            if (_old.map) {
+                auto o = _old.map->probe(hash, h2, key);
+                if (o.found) return _items.size() + o.index;
             }
-            idx = (idx+1) % _items.size();
-        } while (idx != start);
+        }
         return std::size_t(-1);
     }
 
-    constexpr void try_to_fill_gap(std::size_t idx) {
-        auto pos = idx;
-        do {
-            pos = (pos + 1)%_items.size();
+    ///Linear probing - fill the gap after erase
+    /** Entries following the gap are moved to the gap, if the gap is on their probe
+    sequence. The entries are moved directly, without reinsertion, so it never triggers
+    expand or incremental rehash */
+    constexpr void try_to_fill_gap(std::size_t gap) {
+        auto pos = gap;
+        while (true) {
+            pos = next_index(pos);
             if (!is_occupied(pos)) return;  //next is hole, we are done here
-            auto org_idx = map_key(_items[pos].key_value.first);
-            if (org_idx != pos) {   //candidate
-                //try emplace found candidate, so it should fill found gap
-                auto res = try_emplace(_items[pos].key_value.first, std::move(_items[pos].key_value.second));
-                //check if it was inserted - it was probably inserted to found gap
-                if (res.second) {
-                    //however we need to erase previous position
-                    //this can create new gap
-                    erase_index(pos);
-                    return;
-                }
-            }                
-        } while (pos != idx);
+            auto home = home_index(hash_at(pos));
+            //can't move entry, if its home slot is cyclically in (gap, pos]
+            bool stay = gap <= pos ? (gap < home && home <= pos) : (gap < home || home <= pos);
+            if (!stay) {
+                relocate_slot(pos, gap);
+                count_stat(&HashMapStats::erase_moves);
+                set_not_occupied(pos);
+                gap = pos;
+            }
+        }
     }
 
     constexpr void erase_index(std::size_t idx) {
+        if constexpr(incremental) {
+            //entries of old table are only marked as deleted, old table is not searched
+            //for free slots, so it doesn't need to fill gaps
+            if (idx >= _items.size() && idx < slot_count()) {
+                auto &old = *_old.map;
+                idx -= _items.size();
+                if (!old.is_occupied(idx)) return;
+                old.destroy_slot(idx);
+                old._ctrl[idx] = Group::deleted;
+                --old._size;
+                --_size;
+                return;
+            }
+        }
         if (idx >= _items.size() || !is_occupied(idx)) return;
-        std::destroy_at(&_items[idx].key_value);
+        destroy_slot(idx);
         set_not_occupied(idx);
         --_size;
-        try_to_fill_gap(idx);
+        if constexpr(robin_hood) {
+            shift_back(idx);
+        } else {
+            try_to_fill_gap(idx);
+        }
+    }
+
+    constexpr static CtrlArray init_ctrl_array(std::size_t item_count) {
+        CtrlArray r(item_count + Group::width);
+        for (auto &k : r) k = Group::empty;
+        return r;
+    }
+
+    constexpr static auto init_hash_array(std::size_t item_count) {
+        if constexpr(store_hash) {
+            return Array<std::size_t>(item_count);
+        } else {
+            return _details::HashMapNone{};
+        }
     }
 
-    constexpr static FixSizeVector<std::uint8_t> initStateArray(std::size_t item_count) {            
-        FixSizeVector<std::uint8_t> r((item_count + 8)>>3);
-        for (auto &k : r) k = 0;
-        r[item_count >> 3] |= (1 << (item_count & 7));   
-        return r;         
+    constexpr static auto init_value_array(std::size_t item_count) {
+        if constexpr(split) {
+            return Array<ValueItem>(item_count);
+        } else {
+            return _details::HashMapNone{};
+        }
+    }
+
+    constexpr static auto init_dist_array(std::size_t item_count) {
+        if constexpr(robin_hood) {
+            return Array<std::uint8_t>(item_count);
+        } else {
+            return _details::HashMapNone{};
+        }
     }
 
 
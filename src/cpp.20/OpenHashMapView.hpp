@@ -0,0 +1,376 @@
+/**
+@file OpenHashMapView.hpp
+
+Binary image of OpenHashMap and read-only view, which serves lookups directly from the image
+
+@code
+using Map = OpenHashMap<std::uint64_t, Record>;
+using View = OpenHashMapView<std::uint64_t, Record>;
+
+//save
+std::ofstream f("table.bin", std::ios::binary);
+View::write(map, [&](std::span<const std::byte> data) {
+    f.write(reinterpret_cast<const char *>(data.data()), data.size());
+});
+
+//load
+MappedFile file("table.bin");
+View view(file.bytes());
+auto iter = view.find(key);
+@endcode
+
+The image is position independent (it contains only offsets), so it can be mapped at any
+address and shared between processes. The image uses native byte order and native
+layout of the key and the value. The hash function must produce the same results
+in the process which writes the image and in the process which reads it.
+
+*/
+
+#pragma once
+#ifndef uuid1f7b92c4_0e5d_4b38_a6c1_9d24e8f03b57
+#define uuid1f7b92c4_0e5d_4b38_a6c1_9d24e8f03b57
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "OpenHashMap.hpp"
+
+///Header of binary image of OpenHashMap
+/** All offsets are relative to beginning of the image */
+struct OpenHashMapImageHeader {
+    static constexpr char signature[8] = {'O','H','M','I','M','G','0','1'};
+    static constexpr std::uint32_t native_byte_order = 0x01020304;
+    static constexpr std::uint32_t current_version = 1;
+    ///alignment of arrays in the image
+    static constexpr std::size_t alignment = 64;
+
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t key_size;
+    std::uint32_t key_align;
+    std::uint32_t value_size;
+    std::uint32_t value_align;
+    ///size of std::size_t (hash)
+    std::uint32_t hash_size;
+    ///capacity policy: 1 - PrimeCapacity, 2 - PowerOfTwoCapacity, 0 - other
+    std::uint32_t capacity_policy;
+    std::uint64_t capacity;
+    std::uint64_t size;
+    ///control bytes (capacity + group width)
+    std::uint64_t ctrl_offset;
+    ///array of keys (capacity)
+    std::uint64_t keys_offset;
+    ///array of values (capacity)
+    std::uint64_t values_offset;
+    std::uint64_t total_size;
+};
+
+///Read-only view of binary image of OpenHashMap
+/**
+Template arguments must match the map, which was used to write the image (options, which
+don't affect the capacity policy, can differ). The key and the value must be trivially
+copyable. The image stores control bytes, keys and values in separate arrays, so the
+probe touches only control bytes and keys.
+
+The view doesn't own the image, the image must stay valid during lifetime of the view.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename ... Options>
+class OpenHashMapView {
+
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "Key and value must be trivially copyable");
+    static_assert(alignof(K) <= OpenHashMapImageHeader::alignment && alignof(V) <= OpenHashMapImageHeader::alignment);
+
+    using Map = OpenHashMap<K, V, Hash, Equal, Options...>;
+    using Group = _details::HashMapGroup;
+    using Capacity = typename Map::Capacity;
+    using Header = OpenHashMapImageHeader;
+
+    static constexpr bool transparent = Map::transparent;
+
+public:
+
+    struct Ref {
+        const K &first;
+        const V &second;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_concept  = std::forward_iterator_tag;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Ref;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = Ref;
+
+        const_iterator() = default;
+        const_iterator(const OpenHashMapView *view, std::size_t idx):_view(view), _idx(idx) {}
+
+        Ref operator*() const {return {_view->_keys[_idx], _view->_values[_idx]};}
+        _details::HashMapArrow<Ref> operator->() const {return {**this};}
+        const_iterator &operator++() {
+            _idx = _view->next_occupied(_idx + 1);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        bool operator==(const const_iterator &other) const {return _idx == other._idx;}
+
+    protected:
+        const OpenHashMapView *_view = nullptr;
+        std::size_t _idx = 0;
+    };
+
+    using iterator = const_iterator;
+
+    OpenHashMapView() = default;
+
+    ///Construct view
+    /**
+    @param image binary image created by write()
+    @param hasher hasher
+    @param equal comparator
+    @exception std::invalid_argument image is not valid, or it was created for different types
+     */
+    explicit OpenHashMapView(std::span<const std::byte> image, Hash hasher = {}, Equal equal = {})
+        :_hasher(std::move(hasher)), _eq(std::move(equal)) {
+        if (image.size() < sizeof(Header)) invalid("image is too short");
+        Header hdr;
+        std::memcpy(&hdr, image.data(), sizeof(hdr));
+        if (!std::equal(std::begin(hdr.magic), std::end(hdr.magic), std::begin(Header::signature))) invalid("bad signature");
+        if (hdr.byte_order != Header::native_byte_order) invalid("different byte order");
+        if (hdr.version != Header::current_version) invalid("unsupported version");
+        auto expected = make_header(0, 0);
+        if (hdr.key_size != expected.key_size || hdr.key_align != expected.key_align
+            || hdr.value_size != expected.value_size || hdr.value_align != expected.value_align
+            || hdr.hash_size != expected.hash_size) invalid("key or value type mismatch");
+        if (hdr.capacity_policy != expected.capacity_policy) invalid("capacity policy mismatch");
+        auto cap = hdr.capacity;
+        auto total = hdr.total_size;
+        if (total > image.size()
+            || (cap && (!fits(hdr.ctrl_offset, cap, 1, total)
+                        || !fits(hdr.ctrl_offset + cap, Group::width, 1, total)))
+            || !fits(hdr.keys_offset, cap, sizeof(K), total)
+            || !fits(hdr.values_offset, cap, sizeof(V), total)
+            || hdr.size > cap) invalid("image is truncated or damaged");
+        auto base = image.data();
+        if (reinterpret_cast<std::uintptr_t>(base + hdr.keys_offset) % alignof(K)
+            || reinterpret_cast<std::uintptr_t>(base + hdr.values_offset) % alignof(V)) invalid("image is not aligned");
+        _capacity = static_cast<std::size_t>(cap);
+        _size = static_cast<std::size_t>(hdr.size);
+        _ctrl = reinterpret_cast<const std::uint8_t *>(base + hdr.ctrl_offset);
+        _keys = std::launder(reinterpret_cast<const K *>(base + hdr.keys_offset));
+        _values = std::launder(reinterpret_cast<const V *>(base + hdr.values_offset));
+    }
+
+    const_iterator begin() const {return const_iterator(this, next_occupied(0));}
+    const_iterator end() const {return const_iterator(this, _capacity);}
+    std::size_t size() const {return _size;}
+    std::size_t capacity() const {return _capacity;}
+    bool empty() const {return _size == 0;}
+
+    const_iterator find(const K &key) const {
+        return find(key, _hasher(key));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    const_iterator find(const Key &key) const {
+        return find(key, _hasher(key));
+    }
+
+    ///Find with precalculated hash (result of the hasher)
+    const_iterator find(const K &key, std::size_t hash) const {
+        return const_iterator(this, find_index(key, Map::mix_hash(hash)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    const_iterator find(const Key &key, std::size_t hash) const {
+        return const_iterator(this, find_index(key, Map::mix_hash(hash)));
+    }
+
+    bool contains(const K &key) const {
+        return find(key) != end();
+    }
+
+    template<typename Key>
+    requires(transparent)
+    bool contains(const Key &key) const {
+        return find(key) != end();
+    }
+
+    const V &at(const K &key) const {
+        return at_impl(key);
+    }
+
+    template<typename Key>
+    requires(transparent)
+    const V &at(const Key &key) const {
+        return at_impl(key);
+    }
+
+    ///Calculate size of the image
+    static std::size_t image_size(const Map &map) {
+        return static_cast<std::size_t>(make_header(map.capacity(), map.size()).total_size);
+    }
+
+    ///Write binary image of the map
+    /**
+    @param map map to write. If incremental rehash is in progress, it is finished
+    @param output function, which receives std::span<const std::byte> with parts of the image.
+    The image is written sequentially
+     */
+    template<typename Fn>
+    static void write(Map &map, Fn &&output) {
+        if constexpr(Map::incremental) {
+            if (map._old.map) map.migrate(std::size_t(-1));
+        }
+        std::size_t cap = map.capacity();
+        auto hdr = make_header(cap, map.size());
+        std::vector<std::byte> buffer;
+        buffer.reserve(write_buffer_size);
+        std::size_t pos = 0;
+        auto flush = [&]{
+            if (!buffer.empty()) output(std::span<const std::byte>(buffer.data(), buffer.size()));
+            buffer.clear();
+        };
+        auto put = [&](const void *data, std::size_t sz) {
+            auto b = static_cast<const std::byte *>(data);
+            if (buffer.size() + sz > write_buffer_size) flush();
+            if (sz >= write_buffer_size) output(std::span<const std::byte>(b, sz));
+            else buffer.insert(buffer.end(), b, b + sz);
+            pos += sz;
+        };
+        auto pad = [&](std::size_t to) {
+            if (to > pos) {
+                buffer.resize(buffer.size() + (to - pos), std::byte{});
+                pos = to;
+            }
+        };
+        auto put_slots = [&](std::size_t item_size, auto &&get) {
+            for (std::size_t i = 0; i < cap; ++i) {
+                if (map.is_occupied(i)) put(get(i), item_size);
+                else pad(pos + item_size);
+                if (buffer.size() >= write_buffer_size) flush();
+            }
+        };
+        put(&hdr, sizeof(hdr));
+        pad(static_cast<std::size_t>(hdr.ctrl_offset));
+        if (cap) put(map._ctrl.data(), cap + Group::width);
+        pad(static_cast<std::size_t>(hdr.keys_offset));
+        put_slots(sizeof(K), [&](std::size_t i) {return &map.key_at(i);});
+        pad(static_cast<std::size_t>(hdr.values_offset));
+        put_slots(sizeof(V), [&](std::size_t i) -> const V * {
+            if constexpr(Map::split) return &map._values[i].data;
+            else return &map._items[i].data.second;
+        });
+        pad(static_cast<std::size_t>(hdr.total_size));
+        flush();
+    }
+
+protected:
+
+    static constexpr std::size_t write_buffer_size = 1 << 20;
+
+    const std::uint8_t *_ctrl = nullptr;
+    const K *_keys = nullptr;
+    const V *_values = nullptr;
+    std::size_t _capacity = 0;
+    std::size_t _size = 0;
+    [[no_unique_address]] Hash _hasher = {};
+    [[no_unique_address]] Equal _eq = {};
+
+    [[noreturn]] static void invalid(const char *msg) {
+        throw std::invalid_argument(std::string("OpenHashMapView: ") + msg);
+    }
+
+    ///Returns true, if array of count items at offset ends within total size (without overflow)
+    static constexpr bool fits(std::uint64_t offset, std::uint64_t count, std::size_t item_size, std::uint64_t total) {
+        return offset <= total && count <= (total - offset) / item_size;
+    }
+
+    static constexpr std::uint64_t align_up(std::uint64_t v) {
+        return (v + Header::alignment - 1) & ~std::uint64_t(Header::alignment - 1);
+    }
+
+    static constexpr std::uint32_t capacity_policy_id() {
+        if constexpr(std::is_same_v<Capacity, PrimeCapacity>) return 1;
+        else if constexpr(std::is_same_v<Capacity, PowerOfTwoCapacity>) return 2;
+        else return 0;
+    }
+
+    static Header make_header(std::size_t cap, std::size_t size) {
+        Header hdr = {};
+        std::copy(std::begin(Header::signature), std::end(Header::signature), hdr.magic);
+        hdr.byte_order = Header::native_byte_order;
+        hdr.version = Header::current_version;
+        hdr.key_size = sizeof(K);
+        hdr.key_align = alignof(K);
+        hdr.value_size = sizeof(V);
+        hdr.value_align = alignof(V);
+        hdr.hash_size = sizeof(std::size_t);
+        hdr.capacity_policy = capacity_policy_id();
+        hdr.capacity = cap;
+        hdr.size = size;
+        hdr.ctrl_offset = align_up(sizeof(Header));
+        hdr.keys_offset = align_up(hdr.ctrl_offset + (cap?cap + Group::width:0));
+        hdr.values_offset = align_up(hdr.keys_offset + cap * sizeof(K));
+        hdr.total_size = align_up(hdr.values_offset + cap * sizeof(V));
+        return hdr;
+    }
+
+    template<typename Key>
+    const V &at_impl(const Key &key) const {
+        auto idx = find_index(key, Map::mix_hash(_hasher(key)));
+        if (idx == _capacity) throw std::out_of_range("OpenHashMapView::at - key not found");
+        return _values[idx];
+    }
+
+    std::size_t next_occupied(std::size_t idx) const {
+        while (idx < _capacity && (_ctrl[idx] & Group::empty)) ++idx;
+        return idx;
+    }
+
+    ///Walk probe sequence (same as linear probing of the map)
+    /** Robin Hood early exit is not used, the probe stops at first empty slot
+    @return index of slot or capacity, if not found */
+    template<typename Key>
+    std::size_t find_index(const Key &key, std::size_t hash) const {
+        const std::size_t cap = _capacity;
+        if (cap == 0) return cap;
+        auto h2 = Map::fingerprint(hash);
+        std::size_t pos = Capacity::home_index(hash, cap);
+        std::size_t dist = 0;
+        while (dist < cap) {
+            std::size_t cnt = std::min(cap - pos, std::min(cap - dist, Group::width));
+            const std::uint8_t *ctrl = _ctrl + pos;
+            auto valid = Group::prefix(cnt);
+            auto empty = Group::match_empty(ctrl) & valid;
+            auto match = Group::match(ctrl, h2) & valid & ((empty & (~empty + 1)) - 1);
+            while (match) {
+                std::size_t i = Group::index(match);
+                if (_eq(_keys[pos + i], key)) return pos + i;
+                match &= match - 1;
+            }
+            if (empty) return cap;
+            dist += cnt;
+            pos += cnt;
+            if (pos == cap) pos = 0;
+        }
+        return cap;
+    }
+};
+
+
+#endif
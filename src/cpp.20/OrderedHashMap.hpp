@@ -0,0 +1,370 @@
+/**
+@file OrderedHashMap.hpp
+
+Hash map, which keeps items in insertion order, constexpr testable
+
+*/
+
+#pragma once
+#ifndef uuid7e2d05a9_93c4_4f61_b8a0_5c1e4f27d6b3
+#define uuid7e2d05a9_93c4_4f61_b8a0_5c1e4f27d6b3
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "OpenHashMap.hpp"
+
+///Hash map, which keeps items densely in insertion order
+/**
+Items are stored in a vector in order of insertion. The lookup uses a separate
+open addressed index of 32-bit offsets into the vector (linear probing, power of two
+capacity). The index is much smaller than the items and iteration is a linear scan
+of the vector, regardless on how many items were erased.
+
+The map uses the same hash mixing as OpenHashMap and similar API. Full hash of each
+item is stored, so growth of the index never calls the hasher and the stored hash is
+compared before the keys are compared.
+
+Just like FlatMap, items are stored as std::pair<K, V>. Don't modify the key through
+an iterator.
+
+Erase keeps the order of remaining items, which is O(n). Use swap_erase() to erase in
+O(1) - the last item is moved to the erased position.
+
+@tparam K key type
+@tparam V value type
+@tparam Hash hasher
+@tparam Equal comparator
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K> >
+class OrderedHashMap {
+
+    static constexpr bool transparent = requires {
+        typename Hash::is_transparent;
+        typename Equal::is_transparent;
+    };
+
+public:
+
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    constexpr OrderedHashMap() = default;
+    ///Construct map
+    /**
+    @param size expected count of items
+    @param hasher hasher
+    @param equal comparator
+     */
+    constexpr OrderedHashMap(std::size_t size, Hash hasher = {}, Equal equal = {})
+        :_hasher(std::move(hasher)), _eq(std::move(equal)) {
+        reserve(size);
+    }
+
+    constexpr iterator begin() {return _items.begin();}
+    constexpr iterator end() {return _items.end();}
+    constexpr const_iterator begin() const {return _items.begin();}
+    constexpr const_iterator end() const {return _items.end();}
+    constexpr std::size_t size() const {return _items.size();}
+    constexpr bool empty() const {return _items.empty();}
+
+    ///Access item by position (insertion order)
+    constexpr value_type &nth(std::size_t pos) {return _items[pos];}
+    constexpr const value_type &nth(std::size_t pos) const {return _items[pos];}
+
+    constexpr const Hash &hash_function() const {return _hasher;}
+    constexpr const Equal &key_eq() const {return _eq;}
+
+    ///Insert new item, if key doesn't exist
+    /**
+    @param key key
+    @param args arguments to construct value
+    @return pair of iterator and bool, which is true, if the item was inserted
+     */
+    template<typename Key, typename ... Args>
+    constexpr std::pair<iterator, bool> try_emplace(Key &&key, Args && ... args) {
+        if constexpr(!transparent && !std::is_same_v<std::remove_cvref_t<Key>, K>) {
+            return try_emplace(K(std::forward<Key>(key)), std::forward<Args>(args)...);
+        } else {
+            return emplace_hashed(_details::hash_map_mix(_hasher(key)), std::forward<Key>(key), std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename Key, typename... Args>
+    constexpr std::pair<iterator, bool> emplace(Key &&key, Args && ... args) {
+        return try_emplace(std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+    ///Insert new item with precalculated hash (result of hash_function()), if key doesn't exist
+    template<typename Key, typename ... Args>
+    constexpr std::pair<iterator, bool> try_emplace_hashed(std::size_t hash, Key &&key, Args && ... args) {
+        if constexpr(!transparent && !std::is_same_v<std::remove_cvref_t<Key>, K>) {
+            return try_emplace_hashed(hash, K(std::forward<Key>(key)), std::forward<Args>(args)...);
+        } else {
+            return emplace_hashed(_details::hash_map_mix(hash), std::forward<Key>(key), std::forward<Args>(args)...);
+        }
+    }
+
+    constexpr V& operator[](const K &key) {
+        return try_emplace(key).first->second;
+    }
+
+    constexpr iterator find(const K &key) {return make_iterator(find_item(key, hash_key(key)));}
+    constexpr const_iterator find(const K &key) const {return make_iterator(find_item(key, hash_key(key)));}
+
+    template<typename Key>
+    requires(transparent)
+    constexpr iterator find(const Key &key) {return make_iterator(find_item(key, hash_key(key)));}
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key) const {return make_iterator(find_item(key, hash_key(key)));}
+
+    ///Find with precalculated hash (result of hash_function())
+    constexpr iterator find(const K &key, std::size_t hash) {
+        return make_iterator(find_item(key, _details::hash_map_mix(hash)));
+    }
+    constexpr const_iterator find(const K &key, std::size_t hash) const {
+        return make_iterator(find_item(key, _details::hash_map_mix(hash)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr iterator find(const Key &key, std::size_t hash) {
+        return make_iterator(find_item(key, _details::hash_map_mix(hash)));
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr const_iterator find(const Key &key, std::size_t hash) const {
+        return make_iterator(find_item(key, _details::hash_map_mix(hash)));
+    }
+
+    constexpr bool contains(const K &key) const {
+        return find_item(key, hash_key(key)) != npos;
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr bool contains(const Key &key) const {
+        return find_item(key, hash_key(key)) != npos;
+    }
+
+    ///Erase item, keeps order of other items
+    /**
+    @param it iterator
+    @return iterator to next item
+     */
+    constexpr iterator erase(const_iterator it) {
+        auto pos = static_cast<std::size_t>(it - _items.cbegin());
+        erase_at(find_slot_of(pos), pos);
+        return _items.begin() + pos;
+    }
+
+    ///Erase item, keeps order of other items
+    /**
+    @retval true erased
+    @retval false not found
+     */
+    constexpr bool erase(const K &key) {
+        return erase_key(key, hash_key(key), false);
+    }
+
+    template<typename Key>
+    requires(transparent && !std::is_convertible_v<Key, const_iterator>)
+    constexpr bool erase(const Key &key) {
+        return erase_key(key, hash_key(key), false);
+    }
+
+    ///Erase item, the last item is moved to its position - O(1)
+    /**
+    @retval true erased
+    @retval false not found
+     */
+    constexpr bool swap_erase(const K &key) {
+        return erase_key(key, hash_key(key), true);
+    }
+
+    template<typename Key>
+    requires(transparent)
+    constexpr bool swap_erase(const Key &key) {
+        return erase_key(key, hash_key(key), true);
+    }
+
+    constexpr void clear() {
+        _items.clear();
+        _hashes.clear();
+        std::fill(_index.begin(), _index.end(), empty_slot);
+    }
+
+    ///Prepare map for given count of items
+    constexpr void reserve(std::size_t count) {
+        _items.reserve(count);
+        _hashes.reserve(count);
+        auto cap = index_capacity(count);
+        if (cap > _index.size()) rebuild_index(cap);
+    }
+
+    ///Count of slots of the index
+    constexpr std::size_t index_size() const {
+        return _index.size();
+    }
+
+protected:
+
+    static constexpr std::uint32_t empty_slot = 0xFFFFFFFFU;
+    static constexpr std::size_t npos = std::size_t(-1);
+    static constexpr std::size_t min_index = 8;
+
+    std::vector<value_type> _items;
+    ///mixed hash of each item
+    std::vector<std::size_t> _hashes;
+    ///index - offset of item or empty_slot
+    std::vector<std::uint32_t> _index;
+    ///shift of mixed hash to get home slot (highest bits)
+    unsigned int _shift = 0;
+    [[no_unique_address]] Hash _hasher = {};
+    [[no_unique_address]] Equal _eq = {};
+
+    template<typename Key>
+    constexpr std::size_t hash_key(const Key &key) const {
+        return _details::hash_map_mix(_hasher(key));
+    }
+
+    ///capacity of index for given count of items (load factor 3/4 at most)
+    static constexpr std::size_t index_capacity(std::size_t count) {
+        return std::bit_ceil(std::max(min_index, count + count / 3 + 1));
+    }
+
+    constexpr std::size_t home_index(std::size_t hash) const {
+        return hash >> _shift;
+    }
+
+    constexpr std::size_t next_slot(std::size_t slot) const {
+        return (slot + 1) & (_index.size() - 1);
+    }
+
+    constexpr iterator make_iterator(std::size_t pos) {
+        return pos == npos?_items.end():_items.begin() + pos;
+    }
+
+    constexpr const_iterator make_iterator(std::size_t pos) const {
+        return pos == npos?_items.end():_items.begin() + pos;
+    }
+
+    ///Find slot of the index
+    /**
+    @return slot, which contains the key or empty slot, where the key should be inserted
+     */
+    template<typename Key>
+    constexpr std::size_t probe(const Key &key, std::size_t hash) const {
+        auto slot = home_index(hash);
+        while (true) {
+            auto e = _index[slot];
+            if (e == empty_slot || (_hashes[e] == hash && _eq(_items[e].first, key))) return slot;
+            slot = next_slot(slot);
+        }
+    }
+
+    template<typename Key>
+    constexpr std::size_t find_item(const Key &key, std::size_t hash) const {
+        if (_index.empty()) return npos;
+        auto e = _index[probe(key, hash)];
+        return e == empty_slot?npos:e;
+    }
+
+    ///Find slot, which refers to item at given position
+    constexpr std::size_t find_slot_of(std::size_t pos) const {
+        auto slot = home_index(_hashes[pos]);
+        while (_index[slot] != pos) slot = next_slot(slot);
+        return slot;
+    }
+
+    template<typename Key, typename ... Args>
+    constexpr std::pair<iterator, bool> emplace_hashed(std::size_t hash, Key &&key, Args && ... args) {
+        if (index_capacity(_items.size() + 1) > _index.size()) {
+            rebuild_index(index_capacity(_items.size() + 1));
+        }
+        auto slot = probe(key, hash);
+        if (_index[slot] != empty_slot) return {_items.begin() + _index[slot], false};
+        if (_items.size() >= empty_slot) throw std::length_error("OrderedHashMap: too many items");
+        _items.emplace_back(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<Key>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        _hashes.push_back(hash);
+        _index[slot] = static_cast<std::uint32_t>(_items.size() - 1);
+        return {_items.end() - 1, true};
+    }
+
+    constexpr void rebuild_index(std::size_t cap) {
+        _index.assign(cap, empty_slot);
+        _shift = static_cast<unsigned int>(sizeof(std::size_t) * 8 - std::countr_zero(cap));
+        for (std::size_t i = 0; i < _hashes.size(); ++i) {
+            auto slot = home_index(_hashes[i]);
+            while (_index[slot] != empty_slot) slot = next_slot(slot);
+            _index[slot] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    template<typename Key>
+    constexpr bool erase_key(const Key &key, std::size_t hash, bool swap) {
+        if (_index.empty()) return false;
+        auto slot = probe(key, hash);
+        auto e = _index[slot];
+        if (e == empty_slot) return false;
+        if (swap) swap_erase_at(slot, e);
+        else erase_at(slot, e);
+        return true;
+    }
+
+    ///Remove slot from the index (backward shift deletion)
+    constexpr void remove_slot(std::size_t gap) {
+        auto mask = _index.size() - 1;
+        auto slot = gap;
+        while (true) {
+            slot = next_slot(slot);
+            auto e = _index[slot];
+            if (e == empty_slot) break;
+            auto home = home_index(_hashes[e]);
+            //entry can be moved to the gap, if the gap is not before its home slot
+            if (((slot - home) & mask) >= ((slot - gap) & mask)) {
+                _index[gap] = e;
+                gap = slot;
+            }
+        }
+        _index[gap] = empty_slot;
+    }
+
+    constexpr void erase_at(std::size_t slot, std::size_t pos) {
+        remove_slot(slot);
+        _items.erase(_items.begin() + pos);
+        _hashes.erase(_hashes.begin() + pos);
+        if (pos == _items.size()) return;
+        for (auto &e: _index) {
+            if (e != empty_slot && e > pos) --e;
+        }
+    }
+
+    constexpr void swap_erase_at(std::size_t slot, std::size_t pos) {
+        remove_slot(slot);
+        auto last = _items.size() - 1;
+        if (pos != last) {
+            _index[find_slot_of(last)] = static_cast<std::uint32_t>(pos);
+            _items[pos] = std::move(_items[last]);
+            _hashes[pos] = _hashes[last];
+        }
+        _items.pop_back();
+        _hashes.pop_back();
+    }
+};
+
+
+#endif
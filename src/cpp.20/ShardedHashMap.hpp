@@ -0,0 +1,294 @@
+/**
+@file ShardedHashMap.hpp
+
+Concurrent hash map, which partitions keys into shards, each shard is OpenHashMap with own lock
+
+*/
+
+#pragma once
+#ifndef uuid3a9c6f14_d7e2_48b0_85f3_0b6e21c9a7d4
+#define uuid3a9c6f14_d7e2_48b0_85f3_0b6e21c9a7d4
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "OpenHashMap.hpp"
+
+///Concurrent hash map
+/**
+Keys are distributed into shards by high bits of the hash (the hash is mixed again, so
+the bits are independent of bits used by the shard itself). Each shard is an OpenHashMap
+protected by its own reader-writer lock. Readers of a shard don't block each other,
+writers lock only one shard, so expansion of one shard never blocks other shards.
+
+The hash is calculated once per operation and it is passed to the shard.
+
+References to the items can't escape the lock, so lookup functions return a copy of
+the value or call a function while the lock is held.
+
+@tparam K key type
+@tparam V value type
+@tparam Hash hasher
+@tparam Equal comparator
+@tparam Options options of OpenHashMap used for shards (except CollectStats)
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename ... Options>
+class ShardedHashMap {
+public:
+
+    using Map = OpenHashMap<K, V, Hash, Equal, Options...>;
+    //lookups under shared lock would update counters of statistics concurrently
+    static_assert(!_details::hash_map_has_option<CollectStats, Options...>,
+            "CollectStats is not supported, lookups of OpenHashMap with statistics are not thread-safe");
+
+    ///Construct map
+    /**
+    @param shards count of shards, rounded up to power of two. Default is 4 shards per hardware thread
+    @param hasher hasher
+    @param equal comparator
+     */
+    explicit ShardedHashMap(std::size_t shards = default_shard_count(), Hash hasher = {}, Equal equal = {})
+        :_shard_count(std::bit_ceil(std::max<std::size_t>(shards, 1)))
+        ,_shards(std::make_unique<Shard[]>(_shard_count))
+        ,_hasher(hasher) {
+        for (std::size_t i = 0; i < _shard_count; ++i) {
+            _shards[i].map = Map(0, hasher, equal);
+        }
+    }
+
+    ShardedHashMap(const ShardedHashMap &) = delete;
+    ShardedHashMap &operator=(const ShardedHashMap &) = delete;
+
+    std::size_t shard_count() const {return _shard_count;}
+
+    static std::size_t default_shard_count() {
+        return std::bit_ceil(std::max<std::size_t>(std::thread::hardware_concurrency(), 1) * 4);
+    }
+
+    ///Retrieve copy of the value
+    /**
+    @param key key
+    @return copy of the value, or empty if not found
+     */
+    template<typename Key>
+    std::optional<V> get(const Key &key) const {
+        std::optional<V> out;
+        visit(key, [&](const V &v) {out.emplace(v);});
+        return out;
+    }
+
+    template<typename Key>
+    bool contains(const Key &key) const {
+        if constexpr(!lookup_key<Key>) {
+            return contains(K(key));
+        } else {
+            auto hash = _hasher(key);
+            const auto &shard = shard_of(hash);
+            std::shared_lock _(shard.lock);
+            return shard.map.contains(key, hash);
+        }
+    }
+
+    ///Call function with the value under shared lock
+    /**
+    @param key key
+    @param fn function receives const V &. The function must not access this map
+    @retval true found, function called
+    @retval false not found
+     */
+    template<typename Key, typename Fn>
+    bool visit(const Key &key, Fn &&fn) const {
+        if constexpr(!lookup_key<Key>) {
+            return visit(K(key), std::forward<Fn>(fn));
+        } else {
+            auto hash = _hasher(key);
+            const auto &shard = shard_of(hash);
+            std::shared_lock _(shard.lock);
+            auto iter = shard.map.find(key, hash);
+            if (iter == shard.map.end()) return false;
+            fn(std::as_const(iter->second));
+            return true;
+        }
+    }
+
+    ///Insert new item, if key doesn't exist
+    /**
+    @return true, if inserted
+     */
+    template<typename Key, typename ... Args>
+    bool try_emplace(Key &&key, Args && ... args) {
+        if constexpr(!lookup_key<Key>) {
+            return try_emplace(K(std::forward<Key>(key)), std::forward<Args>(args)...);
+        } else {
+            auto hash = _hasher(key);
+            auto &shard = shard_of(hash);
+            std::unique_lock _(shard.lock);
+            return shard.map.try_emplace_hashed(hash, std::forward<Key>(key), std::forward<Args>(args)...).second;
+        }
+    }
+
+    template<typename Key, typename ... Args>
+    bool emplace(Key &&key, Args && ... args) {
+        return try_emplace(std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+    ///Insert new item or replace value of existing item
+    /**
+    @return true, if inserted, false if assigned
+     */
+    template<typename Key, typename Val>
+    bool insert_or_assign(Key &&key, Val &&val) {
+        if constexpr(!lookup_key<Key>) {
+            return insert_or_assign(K(std::forward<Key>(key)), std::forward<Val>(val));
+        } else {
+            auto hash = _hasher(key);
+            auto &shard = shard_of(hash);
+            std::unique_lock _(shard.lock);
+            auto iter = shard.map.find(key, hash);
+            if (iter != shard.map.end()) {
+                iter->second = std::forward<Val>(val);
+                return false;
+            }
+            shard.map.try_emplace_hashed(hash, std::forward<Key>(key), std::forward<Val>(val));
+            return true;
+        }
+    }
+
+    ///Modify value under exclusive lock
+    /**
+    @param key key
+    @param fn function receives V &. The function must not access this map
+    @retval true found, function called
+    @retval false not found
+     */
+    template<typename Key, typename Fn>
+    bool update(const Key &key, Fn &&fn) {
+        if constexpr(!lookup_key<Key>) {
+            return update(K(key), std::forward<Fn>(fn));
+        } else {
+            auto hash = _hasher(key);
+            auto &shard = shard_of(hash);
+            std::unique_lock _(shard.lock);
+            auto iter = shard.map.find(key, hash);
+            if (iter == shard.map.end()) return false;
+            fn(iter->second);
+            return true;
+        }
+    }
+
+    ///Erase item
+    /**
+    @return true, if erased
+     */
+    template<typename Key>
+    bool erase(const Key &key) {
+        if constexpr(!lookup_key<Key>) {
+            return erase(K(key));
+        } else {
+            auto hash = _hasher(key);
+            auto &shard = shard_of(hash);
+            std::unique_lock _(shard.lock);
+            auto iter = shard.map.find(key, hash);
+            if (iter == shard.map.end()) return false;
+            shard.map.erase(iter);
+            return true;
+        }
+    }
+
+    ///Count of items
+    /** Shards are counted one by one, so the result is not exact during concurrent
+    modification */
+    std::size_t size() const {
+        std::size_t sz = 0;
+        for_each_shard([&](const Map &m) {sz += m.size();});
+        return sz;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear() {
+        for_each_shard([](Map &m) {m.clear();});
+    }
+
+    ///Prepare shards for given count of items
+    void reserve(std::size_t count) {
+        auto per_shard = count / _shard_count;
+        per_shard += per_shard / 8 + 1;
+        for_each_shard([&](Map &m) {m.reserve(per_shard);});
+    }
+
+    ///Call function for each item
+    /**
+    @param fn function receives const K & and const V &. Shards are locked one by one
+    (shared lock), so the function must not access this map
+     */
+    template<typename Fn>
+    void for_each(Fn &&fn) const {
+        for_each_shard([&](const Map &m) {
+            for (const auto &[k, v]: m) fn(k, v);
+        });
+    }
+
+    ///Call function for each shard under lock
+    /**
+    @param fn function receives Map &, shards are locked exclusively
+     */
+    template<typename Fn>
+    void for_each_shard(Fn &&fn) {
+        for (std::size_t i = 0; i < _shard_count; ++i) {
+            std::unique_lock _(_shards[i].lock);
+            fn(_shards[i].map);
+        }
+    }
+
+    ///Call function for each shard under shared lock
+    /**
+    @param fn function receives const Map &
+     */
+    template<typename Fn>
+    void for_each_shard(Fn &&fn) const {
+        for (std::size_t i = 0; i < _shard_count; ++i) {
+            std::shared_lock _(_shards[i].lock);
+            fn(std::as_const(_shards[i].map));
+        }
+    }
+
+protected:
+
+    static constexpr bool transparent = requires {
+        typename Hash::is_transparent;
+        typename Equal::is_transparent;
+    };
+    template<typename Key>
+    static constexpr bool lookup_key = transparent || std::is_same_v<std::remove_cvref_t<Key>, K>;
+
+    ///Shard - aligned to cache line, so locks of shards don't share cache line
+    struct alignas(64) Shard {
+        mutable std::shared_mutex lock;
+        Map map;
+    };
+
+    std::size_t _shard_count;
+    std::unique_ptr<Shard[]> _shards;
+    [[no_unique_address]] Hash _hasher;
+
+    Shard &shard_of(std::size_t hash) const {
+        //mix hash differently than the shard, and use high bits
+        std::uint64_t h = hash;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return _shards[static_cast<std::size_t>(h >> 32) & (_shard_count - 1)];
+    }
+};
+
+
+#endif
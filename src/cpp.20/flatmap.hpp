@@ -1,6 +1,18 @@
 #pragma once
 
+#include "module2header.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #define _TOOLBOX_HEADER_BUILD 1
@@ -1,11 +1,34 @@
 #pragma once
 
 #include "module2header.hpp"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 #include "utf8.hpp"
 #include "flatmap.hpp"
 
-#include <variant>
-#include <string>
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
 #include <format>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <variant>
 #include <vector>
 #include "../modules/json.cppm"
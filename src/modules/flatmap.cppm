@@ -1,4 +1,7 @@
 module;
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 #ifndef module
 
 export module ondra.toolbox.flatmap;
@@ -7,6 +10,15 @@ import <vector>;
 import <functional>;
 import <utility>;
 import <algorithm>;
+import <bit>;
+import <cstdint>;
+import <memory>;
+import <iterator>;
+import <ranges>;
+import <stdexcept>;
+import <string_view>;
+import <tuple>;
+import <type_traits>;
 
 #endif
 
@@ -18,6 +30,8 @@ public:
     using value_type = Super::value_type;
     using key_type = K;
     using mapped_type = V;
+    ///Maps up to this count of items are searched by linear scan of tags (see freeze())
+    static constexpr std::size_t scan_limit = 16;
 
     struct CmpPair {
         Cmp cmp;
@@ -27,50 +41,172 @@ public:
         }
     };
 
+protected:
+    ///true for single argument of this type, so it is copied instead of constructing the vector
+    template<typename... Args>
+    static constexpr bool is_self = sizeof...(Args) == 1
+            && (std::is_base_of_v<FlatMap, std::remove_cvref_t<Args> > && ...);
+
+public:
     template<typename ... Args>
-    requires(std::is_constructible_v<Super, Args...>)
+    requires(std::is_constructible_v<Super, Args...> && !is_self<Args...>)
     FlatMap(Args && ... args): Super(std::forward<Args>(args)...) {sort();}
 
     template<typename ... Args>
     requires(std::is_constructible_v<Super, Args...>)
     FlatMap(Args && ... args, Cmp cmp): Super(std::forward<Args>(args)...),_cmp({std::move(cmp)})  {sort();}
 
+    ///Copies the map including appended items and the search index
+    FlatMap(const FlatMap &) = default;
+    FlatMap(FlatMap &&) = default;
+    FlatMap &operator=(const FlatMap &) = default;
+    FlatMap &operator=(FlatMap &&) = default;
+
     using Super::erase;
 
+    ///Find item, appended items are sorted first
     template<typename _K>
-    auto find(const _K &x) const {
+    auto find(const _K &x) {
+        commit();
+        return std::as_const(*this).find(x);
+    }
 
+    ///Find item
+    /** Appended items are searched by linear scan, the map is not modified */
+    template<typename _K>
+    auto find(const _K &x) const {
         auto key =  std::pair<const _K &, std::nullptr_t>(x, nullptr);
-
-        auto iter = std::lower_bound(this->begin(), this->end(),  key, _cmp);
+        if (_pending) return find_pending(key);
+        if constexpr(taggable<_K>) {
+            if (_tags.valid(this->size())) {
+                auto mask = _tags.match(tag_of(x));
+                while (mask) {
+                    auto pos = static_cast<std::size_t>(std::countr_zero(mask));
+                    auto iter = this->begin() + pos;
+                    if (!_cmp(key, *iter) && !_cmp(*iter, key)) return iter;
+                    mask &= mask - 1;
+                }
+                return this->end();
+            }
+        }
+        if (has_index()) {
+            //compare with the key of the index, which is already in cache
+            auto k = search_node([&](const K &k) {return _cmp.cmp(k, x);});
+            if (k == 0 || _cmp.cmp(x, _index->keys[k - 1])) return this->end();
+            return this->begin() + _index->rank[k - 1];
+        }
+        auto iter = lower_bound(x);
         if (iter == this->end()) return iter;
         if (_cmp(key, *iter)) return this->end();
         return iter;
     }
 
+    template<typename _K>
+    auto lower_bound(const _K &x) {
+        commit();
+        return std::as_const(*this).lower_bound(x);
+    }
+
+    ///Find first item not ordered before the key
+    /** @exception std::logic_error the map has appended items, call commit() first */
     template<typename _K>
     auto lower_bound(const _K &x) const {
+        check_committed();
+        if (has_index()) {
+            return node_to_iter(search_node([&](const K &k) {return _cmp.cmp(k, x);}));
+        }
         auto key =  std::pair<const _K &, std::nullptr_t>(x, nullptr);
         return std::lower_bound(this->begin(), this->end(),  key, _cmp);
     }
 
+    template<typename _K>
+    auto upper_bound(const _K &x) {
+        commit();
+        return std::as_const(*this).upper_bound(x);
+    }
+
+    ///Find first item ordered after the key
+    /** @exception std::logic_error the map has appended items, call commit() first */
     template<typename _K>
     auto upper_bound(const _K &x) const {
+        check_committed();
+        if (has_index()) {
+            return node_to_iter(search_node([&](const K &k) {return !_cmp.cmp(x, k);}));
+        }
         auto key =  std::pair<const _K &, std::nullptr_t>(x, nullptr);
-        return std::lower_bound(this->begin(), this->end(),  key, _cmp);
+        return std::upper_bound(this->begin(), this->end(),  key, _cmp);
     }
 
     template<typename _K>
     auto erase(const _K &x) {
         auto iter = find(x);
-        if (iter == this->end()) return iter;
+        if (iter == this->end()) return this->begin() + (iter - this->cbegin());
+        unfreeze();
         return Super::erase(iter);
     }
 
+    ///Exchange content with other map
+    void swap(FlatMap &other) {
+        Super::swap(other);
+        std::swap(_cmp, other._cmp);
+        std::swap(_sorted_count, other._sorted_count);
+        std::swap(_pending, other._pending);
+        std::swap(_index, other._index);
+        std::swap(_tags, other._tags);
+    }
+
+    ///Build search index for read-mostly map
+    /**
+    Copies of keys are stored in Eytzinger (breadth-first) layout. The first levels of the
+    search tree share few cache lines, so they stay in cache, and the traversal is branchless
+    with prefetching of descendants. This helps large maps (millions of items), where the
+    binary search misses the cache at nearly every step. The index needs memory for a copy of
+    keys and one index per item. Iteration order doesn't change.
+
+    Small maps (up to 16 items) with integer or string keys and standard ordering get
+    one byte tags of the keys instead. The tags are compared at once by SIMD instructions,
+    then only the matching keys are compared.
+
+    The index is dropped by any modification through the FlatMap interface. If the
+    underlying vector is modified directly (including keys modified through iterators),
+    call unfreeze() or freeze() again.
+     */
+    void freeze() {
+        commit();
+        if constexpr(use_tags) {
+            if (this->size() <= scan_limit) {
+                _index.reset();
+                retag();
+                return;
+            }
+        }
+        auto idx = std::make_shared<SearchIndex>();
+        auto n = this->size();
+        if (n) idx->keys.assign(n, this->front().first);
+        idx->rank.resize(n);
+        std::size_t pos = 0;
+        build_index(*idx, pos, 1);
+        _index = std::move(idx);
+    }
+
+    ///Drop search index
+    void unfreeze() {
+        _index.reset();
+        if constexpr(use_tags) _tags.active = false;
+    }
+
+    ///Returns true, if the map has search index (see freeze())
+    bool is_frozen() const {
+        return has_index() || _tags.valid(this->size());
+    }
+
     template<typename _K, typename ... Args>
     auto try_emplace(_K &&key, Args &&... value_args) {
         auto iter = lower_bound(key);
-        if (!_cmp(std::pair<const _K &, std::nullptr_t>(key, nullptr), *iter)) return std::pair(this->end(),false);        
+        if (iter != this->end() && !_cmp(std::pair<const _K &, std::nullptr_t>(key, nullptr), *iter)) {
+            return std::pair(this->begin() + (iter - this->cbegin()), false);
+        }
+        unfreeze();
         auto ins = this->insert(iter, value_type(std::forward<_K>(key), V(std::forward<Args>(value_args)...)));
         return std::pair(ins, true);
     }
@@ -86,11 +222,258 @@ public:
         return ins.first->second;
     }
 
+    ///Append item without sorting (builder mode)
+    /**
+    Items are appended to the end. The map is sorted at once before the next lookup or
+    insertion, or by commit(). Duplicate keys are removed then, the first occurrence wins
+    (keys already in the map win over appended keys).
+
+    Iteration doesn't sort the map, call commit() before iteration. A const find()
+    doesn't sort the map, it scans appended items linearly. A const lower_bound() or
+    upper_bound() throws std::logic_error until commit() is called.
+     */
+    template<typename _K, typename ... Args>
+    void append(_K &&key, Args &&... value_args) {
+        unfreeze();
+        if (!_pending) {
+            _sorted_count = this->size();
+            _pending = true;
+        }
+        this->emplace_back(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<_K>(key)),
+                std::forward_as_tuple(std::forward<Args>(value_args)...));
+    }
+
+    ///Sort appended items into the map
+    /**
+    @return count of removed items with duplicate keys
+     */
+    std::size_t commit() {
+        if (!_pending) return 0;
+        _pending = false;
+        unfreeze();
+        auto mid = this->begin() + std::min(_sorted_count, this->size());
+        if (!std::is_sorted(mid, this->end(), _cmp)) {
+            if (this->end() - mid <= 16) {
+                //insertion sort, stable_sort allocates temporary buffer
+                for (auto iter = mid; iter != this->end(); ++iter) {
+                    std::rotate(std::upper_bound(mid, iter, *iter, _cmp), iter, iter + 1);
+                }
+            } else {
+                std::stable_sort(mid, this->end(), _cmp);
+            }
+        }
+        std::inplace_merge(this->begin(), mid, this->end(), _cmp);
+        auto new_end = std::unique(this->begin(), this->end(), [&](const value_type &a, const value_type &b) {
+            return !_cmp(a, b);
+        });
+        auto removed = static_cast<std::size_t>(std::distance(new_end, this->end()));
+        Super::erase(new_end, this->end());
+        return removed;
+    }
+
+    ///Insert multiple items at once
+    /**
+    Items are appended, sorted and merged in one pass, so the complexity is O(N log N)
+    instead of O(N^2) of repeated try_emplace. Existing keys are not replaced.
+    @param first begin of range of items (pairs of key and value)
+    @param last end of range
+    @return count of inserted items
+     */
+    template<std::input_iterator Iter, std::sentinel_for<Iter> Sent>
+    std::size_t insert_range(Iter first, Sent last) {
+        commit();
+        if constexpr(std::forward_iterator<Iter>) {
+            this->reserve(this->size() + static_cast<std::size_t>(std::ranges::distance(first, last)));
+        }
+        auto prev = this->size();
+        for (; first != last; ++first) {
+            auto &&item = *first;
+            append(std::forward<decltype(item)>(item).first, std::forward<decltype(item)>(item).second);
+        }
+        auto added = this->size() - prev;
+        return added - commit();
+    }
+
+    ///Insert multiple items at once, items of rvalue container are moved
+    template<std::ranges::input_range R>
+    std::size_t insert_range(R &&range) {
+        if constexpr(std::is_lvalue_reference_v<R>) {
+            return insert_range(std::ranges::begin(range), std::ranges::end(range));
+        } else {
+            return insert_range(std::make_move_iterator(std::ranges::begin(range)),
+                                std::make_move_iterator(std::ranges::end(range)));
+        }
+    }
+
+    ///Merge other map into this map
+    /** Keys already in this map are not replaced. The source is already sorted, so only
+    a linear merge is performed
+    @return count of inserted items
+    */
+    std::size_t merge(const FlatMap &other) {
+        if (other._pending) {
+            FlatMap tmp(other);
+            tmp.commit();
+            return insert_range(std::move(static_cast<Super &>(tmp)));
+        }
+        return insert_range(other);
+    }
+
+    ///Merge other map into this map, moves items, the source is cleared
+    std::size_t merge(FlatMap &&other) {
+        other.commit();
+        auto r = insert_range(std::move(static_cast<Super &>(other)));
+        other.clear();
+        return r;
+    }
+
 
 protected:
     CmpPair _cmp;
+    ///count of sorted items, when items are appended
+    std::size_t _sorted_count = 0;
+    ///true, if there are appended items, which were not sorted yet
+    bool _pending = false;
+
+    ///Search index - keys in Eytzinger layout
+    struct SearchIndex {
+        ///keys, node k (1-based) is stored at k-1, children of node k are 2k and 2k+1
+        std::vector<K> keys;
+        ///position of the item in the map for each node
+        std::vector<std::size_t> rank;
+    };
+
+    std::shared_ptr<const SearchIndex> _index;
+
+    ///fill nodes by in-order traversal of the implicit tree
+    void build_index(SearchIndex &idx, std::size_t &pos, std::size_t k) {
+        if (k > idx.keys.size()) return;
+        build_index(idx, pos, 2 * k);
+        idx.keys[k - 1] = this->data()[pos].first;
+        idx.rank[k - 1] = pos;
+        ++pos;
+        build_index(idx, pos, 2 * k + 1);
+    }
+
+    ///find first node in order, for which go_right returns false
+    /** @return node index (1-based), 0 if not found */
+    template<typename Fn>
+    std::size_t search_node(Fn &&go_right) const {
+        const SearchIndex &idx = *_index;
+        const K *keys = idx.keys.data();
+        std::size_t n = idx.keys.size();
+        //count of nodes in one cache line, descendants of a node 'levels' deeper are adjacent
+        constexpr std::size_t block = sizeof(K) < 64 ? 64 / sizeof(K) : 1;
+        std::size_t k = 1;
+        while (k <= n) {
+            prefetch(reinterpret_cast<std::uintptr_t>(keys) + (k * block - 1) * sizeof(K));
+            k = 2 * k + static_cast<std::size_t>(go_right(keys[k - 1]));
+        }
+        //remove right turns made after the last left turn, and that left turn
+        return k >> (std::countr_one(k) + 1);
+    }
+
+    auto node_to_iter(std::size_t k) const {
+        if (k == 0) return this->end();
+        return this->begin() + _index->rank[k - 1];
+    }
+
+    static void prefetch(std::uintptr_t addr) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(reinterpret_cast<const void *>(addr));
+#else
+        (void)addr;
+#endif
+    }
+
+    void check_committed() const {
+        if (_pending) throw std::logic_error("FlatMap: uncommitted items, call commit()");
+    }
+
+    ///find item in map with appended items, the first occurrence wins as in commit()
+    template<typename Key>
+    auto find_pending(const Key &key) const {
+        auto mid = this->begin() + std::min(_sorted_count, this->size());
+        auto iter = std::lower_bound(this->begin(), mid, key, _cmp);
+        if (iter != mid && !_cmp(key, *iter)) return iter;
+        iter = std::find_if(mid, this->end(), [&](const value_type &item) {
+            return !_cmp(key, item) && !_cmp(item, key);
+        });
+        return iter;
+    }
 
     void sort() {
         std::sort(this->begin(), this->end(), _cmp);
     }
+
+    ///Tags (one byte fingerprints of the keys) for linear scan of small maps (see freeze())
+    struct Tags {
+        alignas(16) std::uint8_t tag[scan_limit] = {};
+        ///count of valid tags
+        std::uint8_t count = 0;
+        ///tags are built by freeze() and dropped by unfreeze()
+        bool active = false;
+
+        bool valid(std::size_t size) const {
+            return active && count == size;
+        }
+        ///returns bit mask of positions with given tag
+        unsigned int match(std::uint8_t t) const {
+#if defined(__SSE2__) || defined(_M_X64)
+            auto v = _mm_load_si128(reinterpret_cast<const __m128i *>(tag));
+            auto m = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(t)))));
+#else
+            unsigned int m = 0;
+            for (std::size_t i = 0; i < scan_limit; ++i) m |= static_cast<unsigned int>(tag[i] == t) << i;
+#endif
+            return m & ((1U << count) - 1);
+        }
+    };
+
+    struct NoTags {
+        bool valid(std::size_t) const {return false;}
+    };
+
+    ///Tags are used for strings and integers with standard ordering (equivalence is equality)
+    /** Pointers (const char *) are ordered by address, not by content */
+    static constexpr bool use_tags = (std::is_same_v<Cmp, std::less<> > || std::is_same_v<Cmp, std::less<K> >)
+            && !std::is_pointer_v<K>
+            && (std::is_integral_v<K> || std::is_convertible_v<const K &, std::string_view>);
+
+    ///lookup key can be tagged, pointers are excluded, because they can be nullptr
+    template<typename _K>
+    static constexpr bool taggable = use_tags && !std::is_pointer_v<_K> && (std::is_integral_v<K>
+            ? std::is_integral_v<_K> : std::is_convertible_v<const _K &, std::string_view>);
+
+    [[no_unique_address]] std::conditional_t<use_tags, Tags, NoTags> _tags;
+
+    template<typename _K>
+    static std::uint8_t tag_of(const _K &key) {
+        if constexpr(std::is_integral_v<K>) {
+            return static_cast<std::uint8_t>((static_cast<std::uint64_t>(static_cast<K>(key)) * 0x9E3779B97F4A7C15ULL) >> 56);
+        } else {
+            //length, first and last character distinguish most keys of objects
+            std::string_view s(key);
+            if (s.empty()) return 0;
+            return static_cast<std::uint8_t>(s.size() * 31 + static_cast<unsigned char>(s.front()) * 7
+                                             + static_cast<unsigned char>(s.back()));
+        }
+    }
+
+    ///Returns true, if the Eytzinger index is valid
+    bool has_index() const {
+        return _index && _index->keys.size() == this->size();
+    }
+
+    ///build tags of small map
+    void retag() {
+        if constexpr(use_tags) {
+            auto sz = this->size();
+            _tags.active = sz <= scan_limit;
+            if (!_tags.active) return;
+            for (std::size_t i = 0; i < sz; ++i) _tags.tag[i] = tag_of(this->data()[i].first);
+            _tags.count = static_cast<std::uint8_t>(sz);
+        }
+    }
 };
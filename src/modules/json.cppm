@@ -1,4 +1,9 @@
 module;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 #ifndef module
 
 export module ondra.toolbox.json;
@@ -18,24 +23,62 @@ import <charconv>;
 import <algorithm>;
 import <format>;
 import <limits>;
+import <compare>;
+import <mutex>;
+import <shared_mutex>;
+import <string_view>;
+import <unordered_set>;
+import <span>;
+import <cstring>;
+import <cstdint>;
+import <bit>;
+import <iterator>;
+import <memory>;
+import <memory_resource>;
 #endif
 
 export class Json ;
+export class JsonView ;
+
+///Handler of events of JsonSaxParser
+/**
+Strings, keys and numbers are passed as views, which are valid only during the call.
+Strings and keys are decoded, numbers are passed as text
+ */
+export template<typename T>
+concept JsonSaxHandler = requires(T &h, std::string_view s, bool b) {
+    h.start_object();
+    h.end_object();
+    h.start_array();
+    h.end_array();
+    h.key(s);
+    h.string(s);
+    h.number(s);
+    h.boolean(b);
+    h.null();
+};
+
+export template<JsonSaxHandler Handler> class JsonSaxParser;
+
+///Allocator of Json values (see Json::parse, JsonDocument)
+export using JsonAllocator = std::pmr::polymorphic_allocator<char>;
 
 constexpr  bool is_digit(char c){return c>='0' && c <='9';};
 
-export class JsonNumber : public std::string {
+export class JsonNumber : public std::pmr::string {
 public:
     
     JsonNumber() = default;
-    JsonNumber(std::string_view text):std::string(is_valid_number(text)?text:std::string_view()) {}
+    JsonNumber(std::string_view text):std::pmr::string(is_valid_number(text)?text:std::string_view()) {}
+    JsonNumber(std::string_view text, const JsonAllocator &alloc)
+        :std::pmr::string(is_valid_number(text)?text:std::string_view(), alloc) {}
 
     template<typename T>
     requires(std::is_integral_v<T> && std::is_arithmetic_v<T>)
-    JsonNumber(T val):std::string(std::to_string(val)) {};
+    JsonNumber(T val):std::pmr::string(std::to_string(val)) {};
     template<typename T>
     requires(std::is_floating_point_v<T>)
-    JsonNumber(T val):std::string(std::format("{:.12g}", val)) {};
+    JsonNumber(T val):std::pmr::string(std::format("{:.12g}", val)) {};
     
 
     template<typename T>
@@ -89,13 +132,266 @@ public:
 };
 
 
+///Key of Json object
+/**
+The key is either own string, or a handle to string interned in JsonKeyPool. Interned
+keys don't allocate. Keys interned in the same pool are compared by the pointer, keys
+from different pools are compared by the text.
+ */
+export class JsonKey {
+public:
+    JsonKey() = default;
+    JsonKey(std::pmr::string str):_own(std::move(str)) {}
+    JsonKey(const std::string &str):_own(str) {}
+    JsonKey(std::string_view str):_own(str) {}
+    JsonKey(const char *str):_own(str) {}
+    JsonKey(std::string_view str, const JsonAllocator &alloc):_own(str, alloc) {}
+    ///Copy key, own string is allocated by given allocator
+    JsonKey(const JsonKey &other, const JsonAllocator &alloc)
+        :_sym(other._sym), _own(other._own, alloc) {}
+
+    ///Create key from string interned in JsonKeyPool
+    static JsonKey from_interned(const std::string *str) {
+        JsonKey k;
+        k._sym = str;
+        return k;
+    }
+
+    bool is_interned() const {return _sym != nullptr;}
+
+    std::string_view view() const {return _sym?std::string_view(*_sym):std::string_view(_own);}
+    operator std::string_view() const {return view();}
+    std::string str() const {return std::string(view());}
+    std::size_t size() const {return view().size();}
+    bool empty() const {return view().empty();}
+
+    friend bool operator==(const JsonKey &a, const JsonKey &b) {
+        if (a._sym && a._sym == b._sym) return true;
+        return a.view() == b.view();
+    }
+    friend std::strong_ordering operator<=>(const JsonKey &a, const JsonKey &b) {
+        if (a._sym && a._sym == b._sym) return std::strong_ordering::equal;
+        return a.view() <=> b.view();
+    }
+    friend bool operator==(const JsonKey &a, std::string_view b) {
+        return a.view() == b;
+    }
+    friend std::strong_ordering operator<=>(const JsonKey &a, std::string_view b) {
+        return a.view() <=> b;
+    }
+
+protected:
+    ///interned string (owned by the pool)
+    const std::string *_sym = nullptr;
+    std::pmr::string _own;
+};
+
+///Thread safe table of interned keys
+/**
+Strings are never released, so the pool should be used for keys from a limited set
+(names of fields of documents), not for arbitrary data.
+ */
+export class JsonKeyPool {
+public:
+
+    ///global pool
+    static JsonKeyPool &global() {
+        static JsonKeyPool pool;
+        return pool;
+    }
+
+    ///Get interned key
+    JsonKey intern(std::string_view str) {
+        {
+            std::shared_lock _(_mx);
+            auto iter = _strings.find(str);
+            if (iter != _strings.end()) return JsonKey::from_interned(&*iter);
+        }
+        std::unique_lock _(_mx);
+        return JsonKey::from_interned(&*_strings.emplace(str).first);
+    }
+
+    ///count of interned strings
+    std::size_t size() const {
+        std::shared_lock _(_mx);
+        return _strings.size();
+    }
+
+protected:
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const {return std::hash<std::string_view>()(s);}
+    };
+
+    mutable std::shared_mutex _mx;
+    //node based - addresses of strings are stable
+    std::unordered_set<std::string, Hash, std::equal_to<> > _strings;
+};
+
+///Structural index of json document (first stage of indexed parser)
+/**
+The text is processed in blocks of 64 bytes. Each block is classified by SIMD instructions
+(AVX2 or SSE2, scalar code on other platforms) into bit masks of quotes, backslashes,
+structural characters and whitespace. Escaped quotes are removed and the mask of
+strings is calculated by prefix xor. The result is a list of positions of structural
+characters outside of strings, opening quotes of strings and first characters of
+other values (numbers, literals)
+ */
+class JsonStructuralIndex {
+public:
+
+    ///masks of one block
+    struct Block {
+        std::uint64_t quote = 0;
+        std::uint64_t backslash = 0;
+        std::uint64_t structural = 0;
+        std::uint64_t whitespace = 0;
+    };
+
+    ///Build index
+    /**
+    @param text text of the document, must be shorter than 4GB
+    @retval true success
+    @retval false unterminated string
+     */
+    bool build(std::string_view text) {
+        _pos.clear();
+        _pos.resize(std::max<std::size_t>(text.size() / 4, 64));
+        std::size_t count = 0;
+        std::size_t n = text.size();
+        std::size_t full = n & ~std::size_t(63);
+        for (std::size_t i = 0; i < full; i += 64) {
+            count = index_block(classify(text.data() + i), static_cast<std::uint32_t>(i), count);
+        }
+        if (full < n) {
+            char tail[64];
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, text.data() + full, n - full);
+            count = index_block(classify(tail), static_cast<std::uint32_t>(full), count);
+        }
+        _pos.resize(count);
+        return _in_string == 0;
+    }
+
+    const std::vector<std::uint32_t> &positions() const {return _pos;}
+
+    ///classify 64 bytes
+    static Block classify(const char *p) {
+        Block b;
+#if defined(__AVX2__)
+        for (int i = 0; i < 2; ++i) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i * 32));
+            auto eq = [&](char c) {
+                return static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))))) << (i * 32);
+            };
+            //'[' | 0x20 == '{', ']' | 0x20 == '}'
+            __m256i lv = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+            auto leq = [&](char c) {
+                return static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                        _mm256_movemask_epi8(_mm256_cmpeq_epi8(lv, _mm256_set1_epi8(c))))) << (i * 32);
+            };
+            b.quote |= eq('"');
+            b.backslash |= eq('\\');
+            b.structural |= leq('{') | leq('}') | eq(':') | eq(',');
+            b.whitespace |= eq(' ') | eq('\n') | eq('\r') | eq('\t');
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i * 16));
+            auto eq = [&](char c) {
+                return static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))) << (i * 16);
+            };
+            __m128i lv = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            auto leq = [&](char c) {
+                return static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lv, _mm_set1_epi8(c)))) << (i * 16);
+            };
+            b.quote |= eq('"');
+            b.backslash |= eq('\\');
+            b.structural |= leq('{') | leq('}') | eq(':') | eq(',');
+            b.whitespace |= eq(' ') | eq('\n') | eq('\r') | eq('\t');
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            std::uint64_t bit = std::uint64_t(1) << i;
+            switch (p[i]) {
+                case '"': b.quote |= bit; break;
+                case '\\': b.backslash |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',': b.structural |= bit; break;
+                case ' ': case '\n': case '\r': case '\t': b.whitespace |= bit; break;
+                default: break;
+            }
+        }
+#endif
+        return b;
+    }
+
+    ///calculate xor of all bits bellow and at each position
+    static constexpr std::uint64_t prefix_xor(std::uint64_t x) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+protected:
+    std::vector<std::uint32_t> _pos;
+    ///first character of next block is escaped
+    std::uint64_t _escaped = 0;
+    ///all ones, if previous block ended inside of string
+    std::uint64_t _in_string = 0;
+    ///last character of previous block was part of number or literal
+    std::uint64_t _scalar = 0;
+
+    ///returns mask of characters escaped by backslash
+    std::uint64_t escaped_chars(std::uint64_t backslash) {
+        std::uint64_t escaped = _escaped;
+        _escaped = 0;
+        backslash &= ~escaped;
+        while (backslash) {
+            int i = std::countr_zero(backslash);
+            backslash &= backslash - 1;
+            if (i == 63) {
+                _escaped = 1;
+            } else {
+                std::uint64_t next = std::uint64_t(1) << (i + 1);
+                escaped |= next;
+                backslash &= ~next;
+            }
+        }
+        return escaped;
+    }
+
+    std::size_t index_block(const Block &b, std::uint32_t offset, std::size_t count) {
+        std::uint64_t escaped = (b.backslash | _escaped) ? escaped_chars(b.backslash) : 0;
+        std::uint64_t quote = b.quote & ~escaped;
+        //strings including opening quote, excluding closing quote
+        std::uint64_t in_string = prefix_xor(quote) ^ _in_string;
+        _in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+        std::uint64_t scalar = ~(b.structural | b.whitespace | quote | in_string);
+        std::uint64_t scalar_start = scalar & ~((scalar << 1) | _scalar);
+        _scalar = scalar >> 63;
+        std::uint64_t bits = (b.structural & ~in_string) | (quote & in_string) | scalar_start;
+        if (count + 64 > _pos.size()) _pos.resize(_pos.size() * 2);
+        std::uint32_t *out = _pos.data() + count;
+        while (bits) {
+            *out++ = offset + static_cast<std::uint32_t>(std::countr_zero(bits));
+            bits &= bits - 1;
+        }
+        return static_cast<std::size_t>(out - _pos.data());
+    }
+};
+
 using JsonTypes = std::variant<
     std::nullptr_t,
-    std::string,
+    std::pmr::string,
     JsonNumber,
     bool,
-    std::vector<Json>,
-    FlatMap<std::string, Json> >;
+    std::pmr::vector<Json>,
+    FlatMap<JsonKey, Json, std::less<>, std::pmr::polymorphic_allocator<std::pair<JsonKey, Json> > > >;
 
 
 std::string string_from_u8(std::u8string_view str) {
@@ -115,14 +411,58 @@ export class Json: public JsonTypes  {
 public:
     using JsonTypes::JsonTypes;
     Json() {};
-    Json(std::string_view str):JsonTypes(std::string(str)) {}
-    Json(std::u8string_view str):JsonTypes(std::string(string_from_u8(str))) {}
+    Json(std::string_view str):JsonTypes(String(str)) {}
+    Json(std::string_view str, const JsonAllocator &alloc):JsonTypes(String(str, alloc)) {}
+    Json(std::u8string_view str):JsonTypes(String(string_from_u8(str))) {}
     Json(const std::u8string &str):Json(std::u8string_view(str)) {}
     Json(std::wstring_view str):Json(string_from_w(str)) {};
     Json(const std::wstring &str):Json(string_from_w(str)) {};
 
-    using Object = FlatMap<std::string, Json> ;
-    using Array = std::vector<Json>;
+    using Allocator = JsonAllocator;
+    using String = std::pmr::string;
+    using Object = FlatMap<JsonKey, Json, std::less<>, std::pmr::polymorphic_allocator<std::pair<JsonKey, Json> > > ;
+    using Key = JsonKey;
+
+    ///Build tags of small object for fast field access (see FlatMap::freeze())
+    /** Large objects are not frozen, the search index would copy all keys */
+    static void freeze_small(Object &obj) {
+        if (obj.size() <= Object::scan_limit) obj.freeze();
+    }
+
+    ///Create interned key (see JsonKeyPool)
+    static JsonKey key(std::string_view name) {
+        return JsonKeyPool::global().intern(name);
+    }
+    using Array = std::pmr::vector<Json>;
+
+    ///Copy value, strings and containers are allocated by given allocator
+    /**
+    Copy constructor always allocates from the default memory resource
+     */
+    Json(const Json &other, const Allocator &alloc) {
+        std::visit([&](const auto &v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr(std::is_same_v<T, Array>) {
+                Array arr(alloc);
+                arr.reserve(v.size());
+                for (const auto &x: v) arr.emplace_back(x, alloc);
+                static_cast<JsonTypes &>(*this) = std::move(arr);
+            } else if constexpr(std::is_same_v<T, Object>) {
+                Object obj(alloc);
+                obj.reserve(v.size());
+                for (const auto &[k, x]: v) obj.append(JsonKey(k, alloc), Json(x, alloc));
+                obj.commit();
+                freeze_small(obj);
+                static_cast<JsonTypes &>(*this) = std::move(obj);
+            } else if constexpr(std::is_same_v<T, String>) {
+                static_cast<JsonTypes &>(*this) = String(v, alloc);
+            } else if constexpr(std::is_same_v<T, JsonNumber>) {
+                static_cast<JsonTypes &>(*this) = JsonNumber(v, alloc);
+            } else {
+                static_cast<JsonTypes &>(*this) = v;
+            }
+        }, static_cast<const JsonTypes &>(other));
+    }
 
     static const Json &empty_json() {
         static Json e;
@@ -132,7 +472,7 @@ public:
     bool is_null() const {return std::holds_alternative<std::nullptr_t>(*this);}
     bool is_bool() const {return std::holds_alternative<bool>(*this);}
     bool is_number() const {return std::holds_alternative<JsonNumber>(*this);}
-    bool is_string() const {return std::holds_alternative<std::string>(*this);}    
+    bool is_string() const {return std::holds_alternative<String>(*this);}    
     bool is_array() const {return std::holds_alternative<Array>(*this);}
     bool is_object() const {return std::holds_alternative<Object>(*this);}
 
@@ -145,7 +485,7 @@ public:
                 auto v = static_cast<int>(std::get<JsonNumber>(*this));
                 return v != 0;            
             } else if (is_string()) {
-                return std::get<std::string>(*this) == "true";
+                return std::get<String>(*this) == "true";
             } else {
                 return false;
             }
@@ -156,7 +496,7 @@ public:
             } else if (is_number()) {
                 return static_cast<T>(std::get<JsonNumber>(*this));                
             } else if (is_string()) {
-                return static_cast<T>(JsonNumber(std::get<std::string>(*this)));
+                return static_cast<T>(JsonNumber(std::get<String>(*this)));
             } 
         } else if constexpr(std::is_convertible_v<std::string_view, T>) {
             if (is_bool()) {
@@ -164,7 +504,7 @@ public:
             } else if (is_number()) {
                 return T(std::get<JsonNumber>(*this));             
             } else if (is_string()) {
-                return std::get<std::string>(*this);
+                return std::get<String>(*this);
             }
         } else if constexpr(std::is_same_v<T, std::wstring>) {
             auto s = this->as<std::string_view>();
@@ -229,7 +569,7 @@ public:
     }
     template<std::invocable<Object &> Fn>
     auto update(Fn &&fn) {
-        if (!is_array()) *this = Object();
+        if (!is_object()) *this = Object();
         return fn(std::get<Object>(*this));
     }
 
@@ -245,13 +585,13 @@ public:
         });
     }
 
-    auto set(std::string key, Json &&value) {
+    auto set(JsonKey key, Json &&value) {
         return update([&](Object &x){
             return x[std::move(key)] = std::move(value);
         });
     }
 
-    auto set(std::string key, const Json &value) {
+    auto set(JsonKey key, const Json &value) {
         return update([&](Object &x){
             return x[std::move(key)] = value;
         });
@@ -317,11 +657,66 @@ public:
     };
 
 
+    ///Parse json
+    /**
+    @param fn function returns next character, or empty value at the end of input
+    @param intern_keys intern keys of objects in the global JsonKeyPool
+    @param alloc allocator of strings and containers (see JsonDocument)
+     */
     template<std::invocable<> Fn>
     requires(std::is_invocable_r_v<std::optional<char>, Fn>)
-    static Json parse(Fn &&fn) {     
+    static Json parse(Fn &&fn, bool intern_keys = false, const Allocator &alloc = {}) {
+        ParseContext ctx{intern_keys, alloc};
         char c= read_skip_ws(fn);
-        return parse_first_chr(c, fn);
+        return parse_first_chr(c, fn, ctx);
+    }
+
+    ///Parse json from contiguous buffer
+    /**
+    The text is scanned directly, whitespace, strings and numbers are consumed in bulk.
+    @param text text of the document. Only whitespace can follow the value
+    @param intern_keys intern keys of objects in the global JsonKeyPool
+    @param alloc allocator of strings and containers (see JsonDocument)
+     */
+    static Json parse(std::string_view text, bool intern_keys = false, const Allocator &alloc = {}) {
+        const char *p = text.data();
+        const char *end = p + text.size();
+        ParseContext ctx{intern_keys, alloc};
+        Json r = parse_buffer(p, end, ctx);
+        skip_ws(p, end);
+        if (p != end) throw ParseError();
+        return r;
+    }
+
+    ///Parse json from contiguous buffer
+    static Json parse(std::span<const std::byte> text, bool intern_keys = false, const Allocator &alloc = {}) {
+        return parse(std::string_view(reinterpret_cast<const char *>(text.data()), text.size()), intern_keys, alloc);
+    }
+
+    ///Parse large document in two stages
+    /**
+    The first stage builds structural index of the whole document by SIMD instructions
+    (see JsonStructuralIndex), the second stage builds the values by walking the index.
+    It needs extra memory for the index (4 bytes per token). Documents over 4GB are
+    parsed by parse()
+    @param text text of the document. Only whitespace can follow the value
+    @param intern_keys intern keys of objects in the global JsonKeyPool
+    @param alloc allocator of strings and containers (see JsonDocument)
+     */
+    static Json parse_indexed(std::string_view text, bool intern_keys = false, const Allocator &alloc = {}) {
+        if (text.size() >= std::numeric_limits<std::uint32_t>::max()) return parse(text, intern_keys, alloc);
+        JsonStructuralIndex index;
+        if (!index.build(text)) throw ParseError();
+        IndexCursor cur{text.data(), text.data() + text.size(),
+                        index.positions().data(), index.positions().data() + index.positions().size()};
+        ParseContext ctx{intern_keys, alloc};
+        Json r = parse_indexed_value(cur, ctx);
+        if (cur.pos != cur.end) throw ParseError();
+        return r;
+    }
+
+    static Json parse_indexed(std::span<const std::byte> text, bool intern_keys = false, const Allocator &alloc = {}) {
+        return parse_indexed(std::string_view(reinterpret_cast<const char *>(text.data()), text.size()), intern_keys, alloc);
     }
 
     Json(std::initializer_list<Json> list) {
@@ -336,6 +731,7 @@ public:
                 auto &arr = x.as_array();
                 obj.emplace(arr[0].as_text(), arr[1]);
             }
+            freeze_small(obj);
             *this = std::move(obj);
         } else {
             *this = Json::Array(list.begin(), list.end());
@@ -345,6 +741,9 @@ public:
 
 protected:
 
+    friend class JsonView;
+    template<JsonSaxHandler Handler> friend class JsonSaxParser;
+
     using ReadChr = std::optional<char>;
 
     template<typename Fn>
@@ -375,6 +774,45 @@ protected:
         }
         fn('"');
     }
+    ///state of the parser
+    /**
+    Items of unfinished containers are collected on stacks, which are reused for
+    all containers of the document. Finished container is allocated at once with
+    exact size, so no memory is wasted by growth of containers (which matters
+    especially in the arena)
+     */
+    struct ParseContext {
+        bool intern_keys;
+        Allocator alloc;
+        std::vector<Json> values = {};
+        std::vector<std::pair<JsonKey, Json> > items = {};
+
+        JsonKey make_key(String &&str) const {
+            return intern_keys?key(str):JsonKey(std::move(str));
+        }
+        ///create array from values above base
+        Json make_array(std::size_t base) {
+            auto first = values.begin() + static_cast<std::ptrdiff_t>(base);
+            Array arr(std::make_move_iterator(first), std::make_move_iterator(values.end()), alloc);
+            values.erase(first, values.end());
+            return Json(std::move(arr));
+        }
+        ///create object from items above base
+        Json make_object(std::size_t base) {
+            auto first = items.begin() + static_cast<std::ptrdiff_t>(base);
+            Object obj(alloc);
+            obj.reserve(static_cast<std::size_t>(items.end() - first));
+            for (auto iter = first; iter != items.end(); ++iter) {
+                obj.append(std::move(iter->first), std::move(iter->second));
+            }
+            items.erase(first, items.end());
+            //duplicate keys are not allowed
+            if (obj.commit()) throw ParseError();
+            freeze_small(obj);
+            return Json(std::move(obj));
+        }
+    };
+
     template<typename Fn>
     static char read_skip_ws(Fn &&fn) {
         ReadChr c = fn();
@@ -385,41 +823,41 @@ protected:
         return *c;
     }
     template<typename Fn>
-    static Json parse_first_chr(char &c, Fn &&fn) {
+    static Json parse_first_chr(char &c, Fn &&fn, ParseContext &ctx) {
         switch (c) {
             case 't': check(c, fn, "true"); c = 0; return Json(true);
             case 'f': check(c, fn, "false"); c = 0; return Json(false);
             case 'n': check(c, fn, "null"); c = 0; return Json(nullptr);
-            case '"': c =0; return Json(parse_string(fn));
+            case '"': c =0; return Json(parse_string(fn, ctx.alloc));
             case '[':  {
-                Array arr;
+                auto base = ctx.values.size();
                 c = read_skip_ws(fn);
                 if (c != ']') {
-                    arr.push_back(parse_first_chr(c,fn));
+                    ctx.values.push_back(parse_first_chr(c, fn, ctx));
                     if (!c) c = read_skip_ws(fn);
                     while (c != ']') {
                         if (c != ',') throw ParseError();
                         c = read_skip_ws(fn);
-                        arr.push_back(parse_first_chr(c, fn));
+                        ctx.values.push_back(parse_first_chr(c, fn, ctx));
                         if (!c) c = read_skip_ws(fn);
                     }
                 }
                 c = 0;
-                return Json(std::move(arr));                
+                return ctx.make_array(base);
             }
             case '{': {
-                Object obj;
+                auto base = ctx.items.size();
                 c = read_skip_ws(fn);
                 if (c != '}') {
                     if (c!='"') throw ParseError();
                     while (true) {
-                        std::string k = parse_string(fn);
+                        JsonKey k = ctx.make_key(parse_string(fn, ctx.alloc));
                         c = read_skip_ws(fn);
                         if (c!=':') throw ParseError();
                         c = read_skip_ws(fn);
-                        auto v = parse_first_chr(c, fn);
+                        auto v = parse_first_chr(c, fn, ctx);
                         if (!c) c = read_skip_ws(fn);
-                        if (!obj.emplace(std::move(k), std::move(v)).second) throw ParseError();
+                        ctx.items.emplace_back(std::move(k), std::move(v));
                         if (c == ',') {
                             c = read_skip_ws(fn);
                             continue;
@@ -431,10 +869,10 @@ protected:
                     }
                 }
                 c = 0;
-                return Json(std::move(obj));
+                return ctx.make_object(base);
             }
             default:
-                return Json(parse_number(c, fn));
+                return Json(parse_number(c, fn, ctx.alloc));
         }
     }
 
@@ -446,22 +884,25 @@ protected:
             if (!cc || *cc != x) throw ParseError();            
         }
     }
+    static bool is_number_chr(char c) {
+        return is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    ///parse number, the text of the number is kept
     template<typename Fn>
-    static double parse_number(char &c, Fn &&fn) {
+    static JsonNumber parse_number(char &c, Fn &&fn, const Allocator &alloc) {
         std::string buff;
-        while (is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        while (is_number_chr(c)) {
             buff.push_back(c);
             auto cc = fn();
             c = !cc?' ': *cc;            
         }
-        double v;
-        auto st = std::from_chars(buff.data(), buff.data()+buff.size(), v);
-        if (st.ec != std::errc{} || st.ptr != buff.data()+buff.size()) throw ParseError();
+        if (!JsonNumber::is_valid_number(buff)) throw ParseError();
         if (std::isspace(c)) c = 0;
-        return v;
+        return JsonNumber(buff, alloc);
     }
     template<typename Fn>
-    static std::string parse_string(Fn &&fn) {        
+    static String parse_string(Fn &&fn, const Allocator &alloc) {        
         std::basic_string<char16_t> data;
         char hexbuf[4];
         int m = 0;
@@ -497,8 +938,987 @@ protected:
             }
              cc = fn();
         }
-        std::string out;
+        String out(alloc);
         Utf8<char16_t>::to_utf8(data.begin(), data.end(), std::back_inserter(out));
         return out;
     }
-};
\ No newline at end of file
+
+    static bool is_ws(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    static void skip_ws(const char *&p, const char *end) {
+        while (p != end && is_ws(*p)) ++p;
+    }
+
+    ///skip whitespace and return next character
+    static char next_chr(const char *&p, const char *end) {
+        skip_ws(p, end);
+        if (p == end) throw ParseError();
+        return *p;
+    }
+
+    static void check_token(const char *&p, const char *end, std::string_view token) {
+        if (static_cast<std::size_t>(end - p) < token.size()
+            || std::memcmp(p, token.data(), token.size()) != 0) throw ParseError();
+        p += token.size();
+    }
+
+    ///parse value from buffer, p points to first character of the value (or whitespace)
+    static Json parse_buffer(const char *&p, const char *end, ParseContext &ctx) {
+        switch (next_chr(p, end)) {
+            case 't': check_token(p, end, "true"); return Json(true);
+            case 'f': check_token(p, end, "false"); return Json(false);
+            case 'n': check_token(p, end, "null"); return Json(nullptr);
+            case '"': ++p; return Json(parse_buffer_string(p, end, ctx.alloc));
+            case '[': {
+                ++p;
+                auto base = ctx.values.size();
+                if (next_chr(p, end) == ']') {
+                    ++p;
+                    return ctx.make_array(base);
+                }
+                while (true) {
+                    ctx.values.push_back(parse_buffer(p, end, ctx));
+                    char c = next_chr(p, end);
+                    ++p;
+                    if (c == ']') break;
+                    if (c != ',') throw ParseError();
+                }
+                return ctx.make_array(base);
+            }
+            case '{': {
+                ++p;
+                auto base = ctx.items.size();
+                if (next_chr(p, end) == '}') {
+                    ++p;
+                    return ctx.make_object(base);
+                }
+                while (true) {
+                    if (next_chr(p, end) != '"') throw ParseError();
+                    ++p;
+                    JsonKey k = ctx.make_key(parse_buffer_string(p, end, ctx.alloc));
+                    if (next_chr(p, end) != ':') throw ParseError();
+                    ++p;
+                    auto v = parse_buffer(p, end, ctx);
+                    ctx.items.emplace_back(std::move(k), std::move(v));
+                    char c = next_chr(p, end);
+                    ++p;
+                    if (c == '}') break;
+                    if (c != ',') throw ParseError();
+                }
+                return ctx.make_object(base);
+            }
+            default: {
+                const char *b = p;
+                while (p != end && is_number_chr(*p)) ++p;
+                std::string_view txt(b, p - b);
+                if (!JsonNumber::is_valid_number(txt)) throw ParseError();
+                return Json(JsonNumber(txt, ctx.alloc));
+            }
+        }
+    }
+
+    ///position in structural index
+    struct IndexCursor {
+        const char *text;
+        const char *text_end;
+        const std::uint32_t *pos;
+        const std::uint32_t *end;
+
+        char chr() const {
+            if (pos == end) throw ParseError();
+            return text[*pos];
+        }
+        ///expect character and move to next position
+        void expect(char c) {
+            if (chr() != c) throw ParseError();
+            ++pos;
+        }
+    };
+
+    ///second stage of parse_indexed
+    static Json parse_indexed_value(IndexCursor &cur, ParseContext &ctx) {
+        switch (cur.chr()) {
+            case '"': {
+                const char *p = cur.text + *cur.pos + 1;
+                ++cur.pos;
+                return Json(parse_buffer_string(p, cur.text_end, ctx.alloc));
+            }
+            case '[': {
+                ++cur.pos;
+                auto base = ctx.values.size();
+                if (cur.chr() == ']') {
+                    ++cur.pos;
+                    return ctx.make_array(base);
+                }
+                while (true) {
+                    ctx.values.push_back(parse_indexed_value(cur, ctx));
+                    char c = cur.chr();
+                    ++cur.pos;
+                    if (c == ']') break;
+                    if (c != ',') throw ParseError();
+                }
+                return ctx.make_array(base);
+            }
+            case '{': {
+                ++cur.pos;
+                auto base = ctx.items.size();
+                if (cur.chr() == '}') {
+                    ++cur.pos;
+                    return ctx.make_object(base);
+                }
+                while (true) {
+                    if (cur.chr() != '"') throw ParseError();
+                    const char *p = cur.text + *cur.pos + 1;
+                    ++cur.pos;
+                    JsonKey k = ctx.make_key(parse_buffer_string(p, cur.text_end, ctx.alloc));
+                    cur.expect(':');
+                    auto v = parse_indexed_value(cur, ctx);
+                    ctx.items.emplace_back(std::move(k), std::move(v));
+                    char c = cur.chr();
+                    ++cur.pos;
+                    if (c == '}') break;
+                    if (c != ',') throw ParseError();
+                }
+                return ctx.make_object(base);
+            }
+            case ']': case '}': case ':': case ',':
+                throw ParseError();
+            default: {
+                //scalar ends at next structural character or whitespace
+                const char *b = cur.text + *cur.pos;
+                ++cur.pos;
+                const char *e = cur.pos == cur.end ? cur.text_end : cur.text + *cur.pos;
+                while (e != b && is_ws(e[-1])) --e;
+                std::string_view txt(b, e - b);
+                if (txt == "true") return Json(true);
+                if (txt == "false") return Json(false);
+                if (txt == "null") return Json(nullptr);
+                if (!JsonNumber::is_valid_number(txt)) throw ParseError();
+                return Json(JsonNumber(txt, ctx.alloc));
+            }
+        }
+    }
+
+    static void append_utf8(String &out, std::uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    static std::uint32_t parse_hex4(const char *&p, const char *end) {
+        if (end - p < 4) throw ParseError();
+        std::uint16_t v;
+        auto st = std::from_chars(p, p + 4, v, 16);
+        if (st.ec != std::errc{} || st.ptr != p + 4) throw ParseError();
+        p += 4;
+        return v;
+    }
+
+    ///parse string, p points after opening quote, it is moved after closing quote
+    static String parse_buffer_string(const char *&p, const char *end, const Allocator &alloc = {}) {
+        const char *b = p;
+        //fast path - no escape sequences
+        while (p != end && *p != '"' && *p != '\\') ++p;
+        if (p == end) throw ParseError();
+        String out(b, p, alloc);
+        while (*p != '"') {
+            //p points to backslash
+            if (++p == end) throw ParseError();
+            char c = *p++;
+            switch (c) {
+                case 'n': out.push_back('\n');break;
+                case 'r': out.push_back('\r');break;
+                case 't': out.push_back('\t');break;
+                case 'f': out.push_back('\f');break;
+                case 'b': out.push_back('\b');break;
+                case '"':
+                case '\\':
+                case '/': out.push_back(c);break;
+                case 'u': {
+                    std::uint32_t cp = parse_hex4(p, end);
+                    //surrogates must form a pair, a lone surrogate is not valid in utf-8
+                    if (cp >= 0xDC00 && cp < 0xE000) throw ParseError();
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        if (end - p < 6 || p[0] != '\\' || p[1] != 'u') throw ParseError();
+                        p += 2;
+                        std::uint32_t lo = parse_hex4(p, end);
+                        if (lo < 0xDC00 || lo >= 0xE000) throw ParseError();
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default: throw ParseError();
+            }
+            b = p;
+            while (p != end && *p != '"' && *p != '\\') ++p;
+            if (p == end) throw ParseError();
+            out.append(b, p);
+        }
+        ++p;
+        return out;
+    }
+};
+
+
+///Read-only view of json document, which is parsed on demand
+/**
+The view references the source text, which must stay valid while the view (or any
+view derived from it) is used. Nothing is parsed during construction. Values are
+located by skipping preceding siblings (only quotes and brackets are matched), strings
+and numbers are decoded when they are accessed. The cost of reading a few fields
+is proportional to the path, not to the size of the document.
+
+Skipped parts are not validated. Errors are reported by ParseError only when
+malformed part of the document is accessed. Missing values are represented by null view
+(same as Json)
+ */
+export class JsonView {
+public:
+
+    using ParseError = Json::ParseError;
+
+    ///Construct null view
+    JsonView() = default;
+    ///Construct view of the document
+    /**
+    @param text text of the document
+     */
+    explicit JsonView(std::string_view text)
+        :_begin(text.data()), _end(text.data() + text.size()) {
+        Json::skip_ws(_begin, _end);
+        if (_begin == _end) _begin = _end = nullptr;
+    }
+    explicit JsonView(std::span<const std::byte> text)
+        :JsonView(std::string_view(reinterpret_cast<const char *>(text.data()), text.size())) {}
+
+    bool is_null() const {return !_begin || *_begin == 'n';}
+    bool is_bool() const {return _begin && (*_begin == 't' || *_begin == 'f');}
+    bool is_number() const {return _begin && Json::is_number_chr(*_begin);}
+    bool is_string() const {return _begin && *_begin == '"';}
+    bool is_array() const {return _begin && *_begin == '[';}
+    bool is_object() const {return _begin && *_begin == '{';}
+
+    ///Convert scalar value, see Json::as(). Arrays and objects are converted to T()
+    /**
+    Views (std::string_view) are not supported, because decoded string is temporary
+     */
+    template<typename T>
+    T as() const {
+        static_assert(!std::is_same_v<T, std::string_view> && !std::is_same_v<T, std::u8string_view>,
+                      "Use as_text()");
+        return to_scalar().template as<T>();
+    }
+
+    auto as_bool() const {return as<bool>();}
+    auto as_int() const {return as<int>();}
+    auto as_unsigned_int() const {return as<unsigned int>();}
+    auto as_long() const {return as<long>();}
+    auto as_unsigned_long() const {return as<unsigned long>();}
+    auto as_float() const {return as<float>();}
+    auto as_double() const {return as<double>();}
+    ///Returns decoded text
+    std::string as_text() const {return std::string(to_scalar().as_text());}
+    std::wstring as_wtext() const {return to_scalar().as_wtext();}
+    JsonNumber as_number() const {
+        if (!is_number()) return JsonNumber();
+        return to_json().as_number();
+    }
+
+    ///Returns raw text of the value (strings are not decoded)
+    std::string_view raw() const {
+        if (!_begin) return "null";
+        const char *p = _begin;
+        skip_value(p, _end);
+        return std::string_view(_begin, p - _begin);
+    }
+
+    ///Parse the value into Json
+    Json to_json(bool intern_keys = false) const {
+        if (!_begin) return Json();
+        const char *p = _begin;
+        Json::ParseContext ctx{intern_keys, {}};
+        return Json::parse_buffer(p, _end, ctx);
+    }
+
+    class ArrayIterator;
+    class ObjectIterator;
+
+    ///Range of items of an array
+    class ArrayRange {
+    public:
+        ArrayIterator begin() const {return ArrayIterator(_begin, _end);}
+        ArrayIterator end() const {return ArrayIterator();}
+        ///Count of items (all items are skipped)
+        std::size_t size() const {return static_cast<std::size_t>(std::distance(begin(), end()));}
+        bool empty() const {return begin() == end();}
+    protected:
+        friend class JsonView;
+        ArrayRange(const char *b, const char *e):_begin(b), _end(e) {}
+        const char *_begin;
+        const char *_end;
+    };
+
+    ///Range of items of an object
+    /** Items are pairs of decoded key and view of the value. The key references
+    the iterator, it is valid until the iterator is moved */
+    class ObjectRange {
+    public:
+        ObjectIterator begin() const {return ObjectIterator(_begin, _end);}
+        ObjectIterator end() const {return ObjectIterator();}
+        std::size_t size() const {return static_cast<std::size_t>(std::distance(begin(), end()));}
+        bool empty() const {return begin() == end();}
+    protected:
+        friend class JsonView;
+        ObjectRange(const char *b, const char *e):_begin(b), _end(e) {}
+        const char *_begin;
+        const char *_end;
+    };
+
+    ///Returns items of array, empty range if the value is not array
+    ArrayRange as_array() const {
+        return is_array()?ArrayRange(_begin, _end):ArrayRange(nullptr, nullptr);
+    }
+    ///Returns items of object, empty range if the value is not object
+    ObjectRange as_object() const {
+        return is_object()?ObjectRange(_begin, _end):ObjectRange(nullptr, nullptr);
+    }
+
+    ///Count of items of array or object
+    std::size_t size() const {
+        if (is_array()) return as_array().size();
+        if (is_object()) return as_object().size();
+        return 0;
+    }
+
+    JsonView operator[](std::size_t index) const {
+        for (auto v: as_array()) {
+            if (!index) return v;
+            --index;
+        }
+        return JsonView();
+    }
+
+    ///Find value of the key. If the key is not unique, first occurrence is returned
+    JsonView operator[](std::string_view key) const {
+        if (!is_object()) return JsonView();
+        const char *p = _begin + 1;
+        if (Json::next_chr(p, _end) == '}') return JsonView();
+        while (true) {
+            if (Json::next_chr(p, _end) != '"') throw ParseError();
+            bool found = key_equal(p, _end, key);
+            if (Json::next_chr(p, _end) != ':') throw ParseError();
+            ++p;
+            Json::skip_ws(p, _end);
+            if (found) return JsonView(p, _end);
+            skip_value(p, _end);
+            char c = Json::next_chr(p, _end);
+            ++p;
+            if (c == '}') return JsonView();
+            if (c != ',') throw ParseError();
+        }
+    }
+
+    class ArrayIterator {
+    public:
+        using value_type = JsonView;
+        using difference_type = std::ptrdiff_t;
+        using reference = JsonView;
+        using pointer = void;
+        using iterator_category = std::input_iterator_tag;
+
+        ArrayIterator() = default;
+        JsonView operator*() const {return JsonView(_pos, _end);}
+        ArrayIterator &operator++() {
+            skip_value(_pos, _end);
+            next(Json::next_chr(_pos, _end));
+            return *this;
+        }
+        ArrayIterator operator++(int) {
+            ArrayIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        bool operator==(const ArrayIterator &other) const {return _pos == other._pos;}
+    protected:
+        friend class ArrayRange;
+        const char *_pos = nullptr;
+        const char *_end = nullptr;
+
+        ///b points to opening bracket
+        ArrayIterator(const char *b, const char *e):_pos(b), _end(e) {
+            if (!b) return;
+            ++_pos;
+            if (Json::next_chr(_pos, _end) == ']') _pos = nullptr;
+        }
+        ///c is separator after the value
+        void next(char c) {
+            ++_pos;
+            if (c == ']') _pos = nullptr;
+            else if (c == ',') Json::skip_ws(_pos, _end);
+            else throw ParseError();
+        }
+    };
+
+    class ObjectIterator {
+    public:
+        using value_type = std::pair<std::string_view, JsonView>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+        using iterator_category = std::input_iterator_tag;
+
+        ObjectIterator() = default;
+        value_type operator*() const {return {_key, JsonView(_value, _end)};}
+        ObjectIterator &operator++() {
+            const char *p = _value;
+            skip_value(p, _end);
+            char c = Json::next_chr(p, _end);
+            ++p;
+            if (c == '}') _pos = nullptr;
+            else if (c == ',') load(p);
+            else throw ParseError();
+            return *this;
+        }
+        ObjectIterator operator++(int) {
+            ObjectIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        bool operator==(const ObjectIterator &other) const {return _pos == other._pos;}
+    protected:
+        friend class ObjectRange;
+        const char *_pos = nullptr;
+        const char *_end = nullptr;
+        const char *_value = nullptr;
+        Json::String _key;
+
+        ///b points to opening brace
+        ObjectIterator(const char *b, const char *e):_end(e) {
+            if (!b) return;
+            ++b;
+            if (Json::next_chr(b, _end) == '}') return;
+            load(b);
+        }
+        ///parse key, p points before the key
+        void load(const char *p) {
+            if (Json::next_chr(p, _end) != '"') throw ParseError();
+            _pos = p++;
+            _key = Json::parse_buffer_string(p, _end);
+            if (Json::next_chr(p, _end) != ':') throw ParseError();
+            ++p;
+            Json::skip_ws(p, _end);
+            if (p == _end) throw ParseError();
+            _value = p;
+        }
+    };
+
+protected:
+    ///first character of the value
+    const char *_begin = nullptr;
+    ///end of the document
+    const char *_end = nullptr;
+
+    JsonView(const char *b, const char *e):_begin(b), _end(e) {
+        if (_begin == _end) throw ParseError();
+    }
+
+    ///parse scalar value, arrays and objects are returned as null
+    Json to_scalar() const {
+        if (is_array() || is_object()) return Json();
+        return to_json();
+    }
+    ///compare key, p points to opening quote, it is moved after closing quote
+    static bool key_equal(const char *&p, const char *end, std::string_view key) {
+        const char *b = ++p;
+        while (p != end && *p != '"' && *p != '\\') ++p;
+        if (p == end) throw ParseError();
+        if (*p == '"') {
+            ++p;
+            return std::string_view(b, p - b - 1) == key;
+        }
+        p = b;
+        return Json::parse_buffer_string(p, end) == key;
+    }
+
+    ///skip string, p points to opening quote, it is moved after closing quote
+    static void skip_string(const char *&p, const char *end) {
+        ++p;
+        while (true) {
+            p = static_cast<const char *>(std::memchr(p, '"', end - p));
+            if (!p) throw ParseError();
+            //count backslashes before the quote
+            const char *q = p;
+            while (q[-1] == '\\') --q;
+            ++p;
+            if (((p - 1 - q) & 1) == 0) return;
+        }
+    }
+
+    ///skip value, p points to first character, it is moved after the value
+    static void skip_value(const char *&p, const char *end) {
+        if (p == end) throw ParseError();
+        switch (*p) {
+            case '"':
+                skip_string(p, end);
+                return;
+            case '[': case '{': {
+                std::size_t depth = 0;
+                while (p != end) {
+                    switch (*p) {
+                        case '"': skip_string(p, end); continue;
+                        case '[': case '{': ++depth; break;
+                        case ']': case '}':
+                            if (--depth == 0) {
+                                ++p;
+                                return;
+                            }
+                            break;
+                        default: break;
+                    }
+                    ++p;
+                }
+                throw ParseError();
+            }
+            case ']': case '}': case ',': case ':':
+                throw ParseError();
+            default:
+                while (p != end && !Json::is_ws(*p) && *p != ',' && *p != ']' && *p != '}' && *p != ':' && *p != '"') ++p;
+                return;
+        }
+    }
+};
+
+
+///Json document allocated in an arena
+/**
+All strings and containers of the document are allocated from one monotonic memory
+resource. Parsing doesn't need a global allocator lock for each value, and
+destruction of the document doesn't walk the tree, the whole arena is released
+at once (O(1) in count of values).
+
+The document is read only, because a value assigned into the tree could allocate
+outside of the arena. To modify the document, copy the root (the copy is allocated
+by the default memory resource) or create new document from the modified value.
+
+The document is movable, not copyable. References to values are stable across moves.
+ */
+export class JsonDocument {
+public:
+
+    using Allocator = JsonAllocator;
+
+    ///Construct document containing null
+    /**
+    @param initial_size size of the first block of the arena
+    @param upstream memory resource, which allocates blocks of the arena
+     */
+    explicit JsonDocument(std::size_t initial_size = 1024,
+                          std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        :_arena(std::make_unique<Arena>(initial_size, upstream)) {}
+
+    ///Copy value into the arena
+    explicit JsonDocument(const Json &value,
+                          std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        :JsonDocument(1024, upstream) {
+        _arena->root = Json(value, get_allocator());
+    }
+
+    ///Parse document, see Json::parse()
+    /**
+    @param text text of the document
+    @param intern_keys intern keys of objects in the global JsonKeyPool
+    @param upstream memory resource, which allocates blocks of the arena
+     */
+    static JsonDocument parse(std::string_view text, bool intern_keys = false,
+                              std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) {
+        //parsed document needs at least same space as the text
+        JsonDocument doc(std::max<std::size_t>(text.size(), 1024), upstream);
+        doc._arena->root = Json::parse(text, intern_keys, doc.get_allocator());
+        return doc;
+    }
+    static JsonDocument parse(std::span<const std::byte> text, bool intern_keys = false,
+                              std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) {
+        return parse(std::string_view(reinterpret_cast<const char *>(text.data()), text.size()), intern_keys, upstream);
+    }
+
+    ///Parse document from callback, see Json::parse()
+    template<std::invocable<> Fn>
+    requires(std::is_invocable_r_v<std::optional<char>, Fn>)
+    static JsonDocument parse(Fn &&fn, bool intern_keys = false,
+                              std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) {
+        JsonDocument doc(4096, upstream);
+        doc._arena->root = Json::parse(std::forward<Fn>(fn), intern_keys, doc.get_allocator());
+        return doc;
+    }
+
+    const Json &root() const {return _arena->root;}
+    const Json &operator*() const {return _arena->root;}
+    const Json *operator->() const {return &_arena->root;}
+    const Json &operator[](std::size_t index) const {return _arena->root[index];}
+    const Json &operator[](std::string_view key) const {return _arena->root[key];}
+
+    ///Allocator, which allocates from the arena
+    Allocator get_allocator() const {return Allocator(&_arena->resource);}
+
+protected:
+
+    struct Arena {
+        std::pmr::monotonic_buffer_resource resource;
+        //not destroyed, the memory is released by the resource
+        union {
+            Json root;
+        };
+
+        Arena(std::size_t initial_size, std::pmr::memory_resource *upstream)
+            :resource(initial_size, upstream) {
+            std::construct_at(&root);
+        }
+        ~Arena() {}
+    };
+
+    std::unique_ptr<Arena> _arena;
+};
+
+
+///Resumable event based (SAX) parser
+/**
+The input is passed in chunks of any size by feed(). The parser keeps its state
+(stack of open containers and unfinished token) between calls, so it can process
+data as they arrive. Events are passed to the handler (see JsonSaxHandler). Memory
+usage doesn't depend on size of the document, only on depth of nesting and length
+of the longest string.
+
+Strings, which are complete in one chunk and contain no escape sequences, are passed
+to the handler without copying.
+
+@tparam Handler handler of events
+ */
+export template<JsonSaxHandler Handler>
+class JsonSaxParser {
+public:
+
+    using ParseError = Json::ParseError;
+
+    explicit JsonSaxParser(Handler handler = {}):_handler(std::move(handler)) {}
+
+    Handler &handler() {return _handler;}
+    const Handler &handler() const {return _handler;}
+
+    ///Process next chunk of the input
+    /**
+    @param chunk next part of the input. The parser doesn't reference the chunk after
+    return, parts of unfinished tokens are copied.
+    @return count of processed bytes. It is less than size of the chunk, if the top
+    level value has been completed (done() is true). Remaining bytes can be passed to
+    the parser after reset() (next document of the stream)
+    @exception ParseError invalid input. The parser must be reset before next use
+     */
+    std::size_t feed(std::string_view chunk) {
+        const char *p = chunk.data();
+        const char *end = p + chunk.size();
+        while (p != end && _state != State::done) {
+            switch (_state) {
+                case State::string:
+                case State::key_string:
+                    if (read_string(p, end)) {
+                        if (_state == State::key_string) {
+                            _handler.key(_token);
+                            _state = State::colon;
+                        } else {
+                            _handler.string(_token);
+                            value_done();
+                        }
+                    }
+                    continue;
+                case State::number:
+                    read_number(p, end);
+                    continue;
+                case State::literal:
+                    read_literal(p, end);
+                    continue;
+                default:
+                    break;
+            }
+            char c = *p++;
+            if (Json::is_ws(c)) continue;
+            switch (_state) {
+                case State::first_item:
+                    if (c == ']') {
+                        close('[');
+                        break;
+                    }
+                    [[fallthrough]];
+                case State::value:
+                    start_value(c, p);
+                    break;
+                case State::first_key:
+                    if (c == '}') {
+                        close('{');
+                        break;
+                    }
+                    [[fallthrough]];
+                case State::key:
+                    if (c != '"') throw ParseError();
+                    start_string(State::key_string);
+                    break;
+                case State::colon:
+                    if (c != ':') throw ParseError();
+                    _state = State::value;
+                    break;
+                case State::after_value:
+                    if (c == ',') _state = _stack.back() == '['?State::value:State::key;
+                    else if (c == ']') close('[');
+                    else if (c == '}') close('{');
+                    else throw ParseError();
+                    break;
+                default:
+                    throw ParseError();
+            }
+        }
+        return static_cast<std::size_t>(p - chunk.data());
+    }
+
+    ///Signal end of the input
+    /**
+    Completes top level number, which has no terminating character
+    @exception ParseError the document is incomplete
+     */
+    void finish() {
+        if (_state == State::number) {
+            finish_number(_buffer);
+        }
+        if (_state != State::done) throw ParseError();
+    }
+
+    ///Returns true, if the top level value is complete
+    bool done() const {return _state == State::done;}
+
+    ///Count of open containers
+    std::size_t depth() const {return _stack.size();}
+
+    ///Prepare the parser for next document, the handler is kept
+    void reset() {
+        _state = State::value;
+        _stack.clear();
+        _buffer.clear();
+        _escape = 0;
+        _high = 0;
+    }
+
+protected:
+
+    enum class State: std::uint8_t {
+        ///expecting value
+        value,
+        ///after '[', expecting value or ']'
+        first_item,
+        ///after '{', expecting key or '}'
+        first_key,
+        ///after ',' in object, expecting key
+        key,
+        ///after key
+        colon,
+        ///expecting ',' or end of container
+        after_value,
+        string,
+        key_string,
+        number,
+        literal,
+        done
+    };
+
+    Handler _handler;
+    State _state = State::value;
+    ///open brackets
+    std::vector<char> _stack;
+    ///parts of unfinished token, or decoded string
+    Json::String _buffer;
+    ///complete string
+    std::string_view _token;
+    ///true, if the content of the string is in _buffer
+    bool _buffered = false;
+    ///escape sequence: 0 - none, 1 - after backslash, 2-5 - reading hex digits
+    int _escape = 0;
+    ///code point of \u sequence
+    std::uint32_t _cp = 0;
+    ///pending high surrogate
+    std::uint32_t _high = 0;
+    ///expected literal and count of matched characters
+    std::string_view _literal;
+    std::size_t _literal_pos = 0;
+
+    void value_done() {
+        _state = _stack.empty()?State::done:State::after_value;
+    }
+
+    void close(char open) {
+        if (_stack.empty() || _stack.back() != open) throw ParseError();
+        _stack.pop_back();
+        if (open == '[') _handler.end_array();
+        else _handler.end_object();
+        value_done();
+    }
+
+    ///c is first character of the value, p points after it
+    void start_value(char c, const char *&p) {
+        switch (c) {
+            case '{':
+                _stack.push_back('{');
+                _handler.start_object();
+                _state = State::first_key;
+                break;
+            case '[':
+                _stack.push_back('[');
+                _handler.start_array();
+                _state = State::first_item;
+                break;
+            case '"':
+                start_string(State::string);
+                break;
+            case 't': start_literal("true"); break;
+            case 'f': start_literal("false"); break;
+            case 'n': start_literal("null"); break;
+            default:
+                if (c != '-' && !is_digit(c)) throw ParseError();
+                //number is read from its first character
+                --p;
+                _buffer.clear();
+                _state = State::number;
+                break;
+        }
+    }
+
+    void start_string(State st) {
+        _state = st;
+        _buffer.clear();
+        _buffered = false;
+    }
+
+    void start_literal(std::string_view lit) {
+        _literal = lit;
+        _literal_pos = 1;
+        _state = State::literal;
+    }
+
+    void read_literal(const char *&p, const char *end) {
+        while (p != end && _literal_pos < _literal.size()) {
+            if (*p++ != _literal[_literal_pos++]) throw ParseError();
+        }
+        if (_literal_pos < _literal.size()) return;
+        if (_literal[0] == 'n') _handler.null();
+        else _handler.boolean(_literal[0] == 't');
+        value_done();
+    }
+
+    void read_number(const char *&p, const char *end) {
+        const char *b = p;
+        while (p != end && Json::is_number_chr(*p)) ++p;
+        if (p == end) {
+            _buffer.append(b, p);
+        } else if (_buffer.empty()) {
+            finish_number(std::string_view(b, p - b));
+        } else {
+            _buffer.append(b, p);
+            finish_number(_buffer);
+        }
+    }
+
+    void finish_number(std::string_view txt) {
+        if (!JsonNumber::is_valid_number(txt)) throw ParseError();
+        _handler.number(txt);
+        _buffer.clear();
+        value_done();
+    }
+
+    ///high surrogate must be followed by low surrogate
+    void check_no_high() const {
+        if (_high) throw ParseError();
+    }
+
+    ///read content of string, returns true, if the string is complete (see _token)
+    bool read_string(const char *&p, const char *end) {
+        while (p != end) {
+            if (_escape == 0) {
+                const char *b = p;
+                while (p != end && *p != '"' && *p != '\\') ++p;
+                if (p != b) {
+                    if (p != end && *p == '"' && !_buffered) {
+                        //whole string is in this chunk
+                        _token = std::string_view(b, p - b);
+                        ++p;
+                        return true;
+                    }
+                    check_no_high();
+                    _buffer.append(b, p);
+                    _buffered = true;
+                }
+                if (p == end) return false;
+                if (*p++ == '"') {
+                    check_no_high();
+                    _token = _buffer;
+                    return true;
+                }
+                _escape = 1;
+                _buffered = true;
+            } else if (_escape == 1) {
+                char c = *p++;
+                if (c == 'u') {
+                    _escape = 2;
+                    _cp = 0;
+                    continue;
+                }
+                _escape = 0;
+                check_no_high();
+                switch (c) {
+                    case 'n': _buffer.push_back('\n');break;
+                    case 'r': _buffer.push_back('\r');break;
+                    case 't': _buffer.push_back('\t');break;
+                    case 'f': _buffer.push_back('\f');break;
+                    case 'b': _buffer.push_back('\b');break;
+                    case '"':
+                    case '\\':
+                    case '/': _buffer.push_back(c);break;
+                    default: throw ParseError();
+                }
+            } else {
+                char c = *p++;
+                std::uint32_t d;
+                if (is_digit(c)) d = static_cast<std::uint32_t>(c - '0');
+                else if (c >= 'a' && c <= 'f') d = static_cast<std::uint32_t>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F') d = static_cast<std::uint32_t>(c - 'A' + 10);
+                else throw ParseError();
+                _cp = (_cp << 4) | d;
+                if (++_escape < 6) continue;
+                _escape = 0;
+                bool low = _cp >= 0xDC00 && _cp < 0xE000;
+                if (_high) {
+                    if (!low) throw ParseError();
+                    Json::append_utf8(_buffer, 0x10000 + ((_high - 0xD800) << 10) + (_cp - 0xDC00));
+                    _high = 0;
+                } else if (low) {
+                    throw ParseError();
+                } else if (_cp >= 0xD800 && _cp < 0xDC00) {
+                    _high = _cp;
+                } else {
+                    Json::append_utf8(_buffer, _cp);
+                }
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,144 @@
+#include <cpp.20/FixSizeVector.hpp>
+#include <cpp.20/HugePageAllocator.hpp>
+#include <cpp.20/OpenHashMap.hpp>
+#include "../common/check.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+template<typename Alloc>
+constexpr int test_fix_size_vector() {
+    FixSizeVector<int, Alloc> a(10);
+    for (int i = 0; i < 10; ++i) a[i] = i;
+    FixSizeVector<int, Alloc> b(a);
+    if (b.size() != 10 || b[9] != 9) return 1;
+    FixSizeVector<int, Alloc> c(std::move(a));
+    if (c.size() != 10 || !a.empty() || c[5] != 5) return 2;
+    FixSizeVector<int, Alloc> d(5, 42);
+    for (int x: d) if (x != 42) return 3;
+    d = c;
+    if (d.size() != 10 || d[3] != 3) return 4;
+    d = FixSizeVector<int, Alloc>();
+    if (!d.empty() || d.data() != nullptr) return 5;
+    return 0;
+}
+
+static_assert(test_fix_size_vector<std::allocator<int> >() == 0);
+static_assert(test_fix_size_vector<AlignedAllocator<int> >() == 0);
+static_assert(test_fix_size_vector<HugePageAllocator<int> >() == 0);
+
+template<std::size_t N>
+constexpr int test_inline_vector(std::size_t count) {
+    InlineFixSizeVector<std::string, N> a(count, "abc");
+    if (a.size() != count || a[count - 1] != "abc") return 1;
+    auto b = a;
+    a[0] = "x";
+    if (b[0] != "abc") return 2;
+    auto c = std::move(a);
+    if (!a.empty() || c[0] != "x" || c.size() != count) return 3;
+    b = std::move(c);
+    if (b[0] != "x" || !c.empty()) return 4;
+    b = InlineFixSizeVector<std::string, N>();
+    if (!b.empty()) return 5;
+    return 0;
+}
+
+static_assert(test_inline_vector<4>(2) == 0);
+static_assert(test_inline_vector<4>(10) == 0);
+
+///allocator, which counts allocations
+template<typename T>
+struct CountingAllocator: std::allocator<T> {
+    static inline int allocations = 0;
+    template<typename U>
+    struct rebind {
+        using other = CountingAllocator<U>;
+    };
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+    T *allocate(std::size_t n) {
+        ++CountingAllocator<char>::allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+int main() {
+    CHECK_EQUAL(test_fix_size_vector<std::allocator<int> >(), 0);
+    CHECK_EQUAL(test_fix_size_vector<AlignedAllocator<int> >(), 0);
+    CHECK_EQUAL(test_fix_size_vector<HugePageAllocator<int> >(), 0);
+
+    {
+        FixSizeVector<char, AlignedAllocator<char, 256> > v(1000);
+        CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(v.data()) % 256, 0);
+        FixSizeVector<double, AlignedAllocator<char>::rebind<double>::other> w(3, 1.5);
+        CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(w.data()) % 64, 0);
+        CHECK_EQUAL(w[2], 1.5);
+    }
+    {
+        //large block - mapped directly
+        FixSizeVector<std::uint64_t, HugePageAllocator<std::uint64_t> > v(1 << 20);
+        CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(v.data()) % 4096, 0);
+        for (std::size_t i = 0; i < v.size(); ++i) v[i] = i;
+        std::uint64_t sum = 0;
+        for (auto x: v) sum += x;
+        CHECK_EQUAL(sum, (std::uint64_t(1 << 20) * ((1 << 20) - 1)) / 2);
+    }
+    {
+        char buffer[4096];
+        std::pmr::monotonic_buffer_resource res(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        pmr::FixSizeVector<std::string> v(10, "hello", &res);
+        CHECK(v.get_allocator().resource() == &res);
+        auto *p = reinterpret_cast<char *>(v.data());
+        CHECK(p >= buffer && p < buffer + sizeof(buffer));
+        pmr::FixSizeVector<std::string> w(std::move(v));
+        CHECK_EQUAL(w[9], "hello");
+        CHECK(w.get_allocator().resource() == &res);
+    }
+    CHECK_EQUAL(test_inline_vector<4>(2), 0);
+    CHECK_EQUAL(test_inline_vector<4>(4), 0);
+    CHECK_EQUAL(test_inline_vector<4>(10), 0);
+    {
+        InlineFixSizeVector<int, 8, CountingAllocator<int> > a(8, 1);
+        CHECK(a.is_inline());
+        CHECK_EQUAL(CountingAllocator<char>::allocations, 0);
+        InlineFixSizeVector<int, 8, CountingAllocator<int> > b(9, 1);
+        CHECK(!b.is_inline());
+        CHECK_EQUAL(CountingAllocator<char>::allocations, 1);
+        auto c = std::move(a);
+        CHECK(c.is_inline());
+        CHECK(c.data() != a.data());
+        CHECK_EQUAL(c[7], 1);
+        CountingAllocator<char>::allocations = 0;
+    }
+    {
+        //small map doesn't allocate
+        using SmallMap = OpenHashMap<int, int, std::hash<int>, std::equal_to<int>,
+                                     InlineStorage<16>, UseAllocator<CountingAllocator<char> >, PowerOfTwoCapacity>;
+        SmallMap hh;
+        for (int i = 0; i < 8; ++i) hh.emplace(i, i * 10);
+        CHECK_EQUAL(CountingAllocator<char>::allocations, 0);
+        SmallMap hh2 = std::move(hh);
+        CHECK_EQUAL(hh2.size(), 8);
+        CHECK_EQUAL(hh2.find(7)->second, 70);
+        CHECK_EQUAL(CountingAllocator<char>::allocations, 0);
+        for (int i = 8; i < 100; ++i) hh2.emplace(i, i * 10);
+        CHECK_GREATER(CountingAllocator<char>::allocations, 0);
+        CHECK_EQUAL(hh2.find(99)->second, 990);
+        hh2.clear();
+        hh2.shrink_to_fit();
+        CountingAllocator<char>::allocations = 0;
+        for (int i = 0; i < 8; ++i) hh2.emplace(i, i);
+        CHECK_EQUAL(CountingAllocator<char>::allocations, 0);
+    }
+    {
+        OpenHashMap<int, std::string, std::hash<int>, std::equal_to<int>, UseAllocator<AlignedAllocator<char> > > hh;
+        for (int i = 0; i < 1000; ++i) hh.emplace(i, std::to_string(i));
+        CHECK_EQUAL(hh.size(), 1000);
+        CHECK_EQUAL(hh.find(500)->second, "500");
+        OpenHashMap<int, int, std::hash<int>, std::equal_to<int>, UseAllocator<HugePageAllocator<char> >, StoreHash> big;
+        big.reserve(200000);
+        for (int i = 0; i < 200000; ++i) big.emplace(i, i);
+        CHECK_EQUAL(big.find(12345)->second, 12345);
+    }
+}
@@ -0,0 +1,59 @@
+#include <cpp.20/FrozenHashMap.hpp>
+#include "../common/check.hpp"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+constexpr auto keywords = make_frozen_hash_map<std::string_view, int>({
+    {"if", 1}, {"else", 2}, {"while", 3}, {"for", 4}, {"do", 5},
+    {"return", 6}, {"break", 7}, {"continue", 8}, {"switch", 9}, {"case", 10},
+    {"default", 11}, {"goto", 12}, {"struct", 13}, {"class", 14}, {"union", 15}
+});
+
+static_assert(keywords.size() == 15);
+static_assert(keywords.at("while") == 3);
+static_assert(keywords.at("union") == 15);
+static_assert(!keywords.contains("whilst"));
+static_assert(!keywords.contains(""));
+
+constexpr std::array<std::pair<int, int>, 1000> generate_items() {
+    std::array<std::pair<int, int>, 1000> out = {};
+    for (int i = 0; i < 1000; ++i) out[i] = {i * 7 + 3, i};
+    return out;
+}
+
+constexpr int test_large_table() {
+    constexpr FrozenHashMap large(generate_items());
+    for (int i = 0; i < 1000; ++i) {
+        auto iter = large.find(i * 7 + 3);
+        if (iter == large.end() || iter->second != i) return 1;
+        if (large.contains(i * 7 + 4)) return 2;
+    }
+    int sum = 0;
+    for (const auto &[k, v]: large) sum += v;
+    return sum == 999*1000/2?0:3;
+}
+static_assert(test_large_table() == 0, "Failed");
+
+constexpr FrozenHashMap<int, int, 0> empty_map(std::array<std::pair<int, int>, 0>{});
+static_assert(empty_map.empty() && !empty_map.contains(1));
+
+int test_runtime_lookup() {
+    //lookup by std::string, which is converted to std::string_view
+    std::string key = "continue";
+    if (keywords.at(key) != 8) return 1;
+    if (keywords.find(std::string("contin")) != keywords.end()) return 2;
+    auto h = keywords.hash_function()(std::string_view("goto"));
+    if (keywords.find("goto", h)->second != 12) return 3;
+    int sum = 0;
+    for (const auto &[k, v]: keywords) sum += keywords.at(k) == v?v:0;
+    return sum == 15*16/2?0:4;
+}
+
+int main() {
+    CHECK_EQUAL(test_large_table(), 0);
+    CHECK_EQUAL(test_runtime_lookup(), 0);
+    CHECK_EXCEPTION(std::out_of_range, keywords.at("missing"));
+    CHECK_EXCEPTION(std::invalid_argument, make_frozen_hash_map<int, int>({{1, 1}, {2, 2}, {1, 3}}));
+    return 0;
+}
@@ -1,4 +1,11 @@
 #include <cpp.20/OpenHashMap.hpp>
+#include "../common/check.hpp"
+#include <stdexcept>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 
 
@@ -25,8 +32,9 @@ public:
 };
 
 
+template<typename ... Options>
 constexpr int test_open_hash() {
-    OpenHashMap<int, TestClass, PrimHash> hh;
+    OpenHashMap<int, TestClass, PrimHash, std::equal_to<int>, Options...> hh;
     for (int i = 0; i < 100; ++i) {
         hh.emplace(i, TestClass(i*2+1));
     }
@@ -67,7 +75,326 @@ constexpr int test_open_hash() {
 }
 
 static_assert(test_open_hash() == 0, "Failed");;
+static_assert(test_open_hash<PowerOfTwoCapacity>() == 0, "Failed");;
+static_assert(test_open_hash<RobinHoodProbing>() == 0, "Failed");;
+static_assert(test_open_hash<PowerOfTwoCapacity, RobinHoodProbing>() == 0, "Failed");;
+
+template<typename ... Options>
+constexpr int test_erase_iterator() {
+    OpenHashMap<int, int, PrimHash, std::equal_to<int>, Options...> hh;
+    for (int i = 0; i < 500; ++i) hh.emplace(i, i);
+    auto iter = hh.begin();
+    while (iter != hh.end()) {
+        if (iter->second & 1) iter = hh.erase(iter);
+        else ++iter;
+    }
+    if (hh.size() != 250) return 1;
+    for (int i = 0; i < 500; ++i) {
+        if ((hh.find(i) == hh.end()) != (i & 1)) return 2;
+    }
+    return 0;
+}
+
+static_assert(test_erase_iterator() == 0, "Failed");;
+static_assert(test_erase_iterator<RobinHoodProbing>() == 0, "Failed");;
+static_assert(test_open_hash<IncrementalRehash<> >() == 0, "Failed");;
+static_assert(test_erase_iterator<IncrementalRehash<4> >() == 0, "Failed");;
+static_assert(test_open_hash<RobinHoodProbing, IncrementalRehash<2> >() == 0, "Failed");;
+
+///during incremental rehash, entries are spread in both tables
+constexpr int test_incremental_rehash() {
+    OpenHashMap<int, int, PrimHash, std::equal_to<int>, IncrementalRehash<2> > hh;
+    int i = 0;
+    auto cap = hh.capacity();
+    for (; i < 1000; ++i) {
+        hh.emplace(i, i);
+        if (cap != hh.capacity() && cap > 16) break;
+        cap = hh.capacity();
+    }
+    //old table is not migrated yet, iterate and erase from both tables
+    std::size_t cnt = 0;
+    for (const auto &[k,v]: hh) {
+        if (k != v) return 1;
+        ++cnt;
+    }
+    if (cnt != hh.size()) return 2;
+    for (int j = 0; j <= i; j+=2) hh.erase(j);
+    for (int j = 0; j <= i; ++j) {
+        if ((hh.find(j) == hh.end()) != (j % 2 == 0)) return 3;
+    }
+    if (hh.emplace(1, 42).second) return 4;
+    return 0;
+}
+
+static_assert(test_incremental_rehash() == 0, "Failed");;
+static_assert(test_open_hash<StoreHash>() == 0, "Failed");;
+static_assert(test_erase_iterator<StoreHash, RobinHoodProbing>() == 0, "Failed");;
+
+///hasher, which counts its calls
+struct CountingHash {
+    int *counter;
+    std::size_t operator()(const std::string &s) const {
+        ++*counter;
+        return std::hash<std::string>()(s);
+    }
+};
+
+int test_store_hash() {
+    int counter = 0;
+    OpenHashMap<std::string, int, CountingHash, std::equal_to<std::string>, StoreHash> hh(0, CountingHash{&counter});
+    for (int i = 0; i < 1000; ++i) hh.emplace(std::to_string(i), i);
+    //expand and rehash must not call hasher
+    if (counter != 1000) return 1;
+    for (int i = 0; i < 1000; i+=2) hh.erase(std::to_string(i));
+    if (counter != 1500) return 2;
+    for (int i = 0; i < 1000; ++i) {
+        if ((hh.find(std::to_string(i)) == hh.end()) != (i % 2 == 0)) return 3;
+    }
+    return 0;
+}
+
+///all keys share the same home slot, lookups must rely on fingerprints and key compare
+struct BadHash {
+    constexpr std::size_t operator()(const std::string &) const {return 42;}
+};
+
+template<typename ... Options>
+int test_collisions(int count) {
+    OpenHashMap<std::string, int, BadHash, std::equal_to<std::string>, Options...> hh;
+    for (int i = 0; i < count; ++i) {
+        hh.emplace(std::to_string(i), i);
+    }
+    for (int i = 0; i < count; ++i) {
+        auto iter = hh.find(std::to_string(i));
+        if (iter == hh.end()) return 1;
+        if (iter->second != i) return 2;
+    }
+    for (int i = 0; i < count; i+=3) {
+        hh.erase(std::to_string(i));
+    }
+    for (int i = 0; i < count; ++i) {
+        auto iter = hh.find(std::to_string(i));
+        if ((iter == hh.end()) != (i % 3 == 0)) return 3;
+    }
+    if (hh.size() != static_cast<std::size_t>(count - (count + 2) / 3)) return 4;
+    return 0;
+}
+
+struct TransparentHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const {return std::hash<std::string_view>()(s);}
+};
+
+///counts allocations of keys
+struct CountedKey: std::string {
+    static inline int constructed = 0;
+    explicit CountedKey(std::string_view s):std::string(s) {++constructed;}
+    CountedKey(const CountedKey &other):std::string(other) {++constructed;}
+    CountedKey(CountedKey &&other) = default;
+};
+
+int test_heterogeneous() {
+    CountedKey::constructed = 0;
+    OpenHashMap<CountedKey, int, TransparentHash, std::equal_to<> > hh;
+    hh.try_emplace(std::string_view("alfa"), 1);
+    hh.try_emplace(std::string_view("beta"), 2);
+    if (CountedKey::constructed != 2) return 1;
+    //lookups and failed insertions don't create key
+    if (!hh.contains(std::string_view("alfa"))) return 2;
+    if (hh.find(std::string_view("beta"))->second != 2) return 3;
+    if (hh.find(std::string_view("gamma")) != hh.end()) return 4;
+    if (hh.try_emplace(std::string_view("alfa"), 3).second) return 5;
+    if (CountedKey::constructed != 2) return 6;
+    //search multiple maps with one hash
+    OpenHashMap<CountedKey, int, TransparentHash, std::equal_to<> > hh2;
+    hh2.try_emplace(std::string_view("beta"), 20);
+    std::string_view k = "beta";
+    auto hash = hh.hash_function()(k);
+    if (hh.find(k, hash)->second != 2) return 7;
+    if (hh2.find(k, hash)->second != 20) return 8;
+    if (!hh2.contains(k, hash)) return 9;
+    hh.erase(std::string_view("alfa"));
+    if (hh.contains(std::string_view("alfa")) || hh.size() != 1) return 10;
+    if (CountedKey::constructed != 3) return 11;    //hh2 insert
+    return 0;
+}
+
+constexpr int test_find_many() {
+    OpenHashMap<int, int, PrimHash> hh;
+    std::vector<int> keys;
+    for (int i = 0; i < 100; ++i) {
+        hh.emplace(i*2, i);
+        keys.push_back(i);
+    }
+    std::vector<decltype(hh)::iterator> res;
+    hh.find_many(keys, std::back_inserter(res));
+    std::vector<bool> flags;
+    hh.contains_many(keys, std::back_inserter(flags));
+    if (res.size() != 100 || flags.size() != 100) return 1;
+    for (int i = 0; i < 100; ++i) {
+        if ((res[i] != hh.end()) != (i % 2 == 0)) return 2;
+        if (res[i] != hh.end() && res[i]->second != i/2) return 3;
+        if (flags[i] != (i % 2 == 0)) return 4;
+    }
+    return 0;
+}
+
+static_assert(test_find_many() == 0, "Failed");;
+static_assert(test_open_hash<SplitKeyValue>() == 0, "Failed");;
+static_assert(test_erase_iterator<SplitKeyValue, RobinHoodProbing>() == 0, "Failed");;
+
+constexpr int test_split_key_value() {
+    OpenHashMap<int, int, PrimHash, std::equal_to<int>, SplitKeyValue, IncrementalRehash<2> > hh;
+    for (int i = 0; i < 100; ++i) hh.emplace(i, i);
+    //modify through proxy
+    for (auto iter = hh.begin(); iter != hh.end(); ++iter) iter->second *= 2;
+    hh[5] = 1;
+    int sum = 0;
+    for (const auto &[k, v]: hh) {
+        if (k != 5 && v != k * 2) return 1;
+        sum += v;
+    }
+    if (sum != 99*100 - 9) return 2;
+    const auto &chh = hh;
+    auto iter = chh.find(7);
+    if (iter == chh.end() || (*iter).second != 14) return 3;
+    return 0;
+}
+
+static_assert(test_split_key_value() == 0, "Failed");;
+
+template<typename ... Options>
+constexpr int test_reserve() {
+    OpenHashMap<int, int, PrimHash, std::equal_to<int>, Options...> hh;
+    hh.reserve(1000);
+    auto cap = hh.capacity();
+    if (cap * 6 < 10000) return 1;
+    for (int i = 0; i < 1000; ++i) hh.emplace(i, i);
+    //no expansion happened
+    if (hh.capacity() != cap) return 2;
+    if (hh.load_factor() > hh.max_load_factor()) return 3;
+    for (int i = 0; i < 900; ++i) hh.erase(i);
+    hh.shrink_to_fit();
+    if (hh.capacity() >= cap / 4) return 4;
+    for (int i = 900; i < 1000; ++i) if (hh.find(i) == hh.end() || hh.find(i)->second != i) return 5;
+    hh.max_load_factor(0.9f);
+    hh.shrink_to_fit();
+    if (hh.load_factor() < 0.5f) return 6;
+    hh.max_load_factor(0.2f);
+    if (hh.load_factor() > 0.2f) return 7;
+    hh.rehash(5000);
+    if (hh.capacity() < 5000) return 8;
+    auto cpy = hh;
+    if (cpy.max_load_factor() != hh.max_load_factor() || cpy.size() != 100) return 9;
+    for (int i = 900; i < 1000; ++i) if (!cpy.contains(i)) return 10;
+    hh.clear();
+    hh.shrink_to_fit();
+    if (hh.capacity() != 0) return 11;
+    hh.emplace(1, 1);
+    return hh.contains(1)?0:12;
+}
+static_assert(test_reserve() == 0, "Failed");;
+
+struct ConstHash {
+    constexpr std::size_t operator()(int) const {return 1;}
+};
+
+template<typename ... Options>
+int test_stats() {
+    OpenHashMap<int, int, PrimHash, std::equal_to<int>, CollectStats, Options...> good;
+    OpenHashMap<int, int, ConstHash, std::equal_to<int>, CollectStats, Options...> bad;
+    for (int i = 0; i < 100; ++i) {
+        good.emplace(i, i);
+        bad.emplace(i, i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        if (!good.contains(i) || !bad.contains(i)) return 1;
+    }
+    auto gs = good.stats();
+    auto bs = bad.stats();
+    if (gs.probes != 200 || bs.probes != 200) return 2;
+    if (gs.expands == 0 || gs.size != 100 || gs.capacity != good.capacity()) return 3;
+    //degenerated hasher is visible in statistics
+    if (bs.max_displacement != 99 || bs.mean_displacement < 40) return 4;
+    if (gs.mean_probe_length() * 10 > bs.mean_probe_length()) return 5;
+    std::uint64_t hist = 0;
+    for (auto x: bs.probe_histogram) hist += x;
+    //probes of length 64 - 99
+    if (hist != bs.probes || bs.probe_histogram[7] == 0) return 6;
+    bad.erase(0);
+    if (bad.stats().erase_moves == 0) return 7;
+    bad.reset_stats();
+    if (bad.stats().probes != 0 || bad.stats().size != 99) return 8;
+    return 0;
+}
+template<typename Map>
+concept has_stats = requires(const Map &hh) {hh.stats();};
+static_assert(!has_stats<OpenHashMap<int, int> >, "stats without CollectStats");
+static_assert(has_stats<OpenHashMap<int, int, std::hash<int>, std::equal_to<int>, CollectStats> >);
+//counting is disabled in constant evaluation
+static_assert(test_open_hash<CollectStats, RobinHoodProbing>() == 0, "Failed");
+
+///random operations compared with std::unordered_map
+template<typename ... Options>
+int test_random() {
+    OpenHashMap<int, int, std::hash<int>, std::equal_to<int>, Options...> hh;
+    std::unordered_map<int, int> ref;
+    std::mt19937 rnd(1);
+    for (int i = 0; i < 200000; ++i) {
+        int k = static_cast<int>(rnd() % 5000);
+        switch (rnd() % 3) {
+            case 0: if (hh.emplace(k, i).second != ref.emplace(k, i).second) return 1; break;
+            case 1: hh.erase(k); ref.erase(k); break;
+            default: {
+                auto iter = hh.find(k);
+                auto riter = ref.find(k);
+                if ((iter == hh.end()) != (riter == ref.end())) return 2;
+                if (iter != hh.end() && iter->second != riter->second) return 3;
+            }
+        }
+        if (hh.size() != ref.size()) return 4;
+    }
+    std::size_t cnt = 0;
+    for (const auto &[k, v]: hh) {
+        if (ref.at(k) != v) return 5;
+        ++cnt;
+    }
+    return cnt == ref.size()?0:6;
+}
 
 int main() {
+    CHECK_EQUAL(test_open_hash(), 0);
+    CHECK_EQUAL(test_collisions(300), 0);
+    CHECK_EQUAL(test_open_hash<PowerOfTwoCapacity>(), 0);
+    CHECK_EQUAL(test_collisions<PowerOfTwoCapacity>(300), 0);
+    CHECK_EQUAL(test_open_hash<RobinHoodProbing>(), 0);
+    CHECK_EQUAL(test_erase_iterator<RobinHoodProbing>(), 0);
+    CHECK_EQUAL(test_collisions<RobinHoodProbing>(200), 0);
+    CHECK_EXCEPTION(std::length_error, test_collisions<RobinHoodProbing>(300));
+    CHECK_EQUAL(test_random(), 0);
+    CHECK_EQUAL(test_random<PowerOfTwoCapacity>(), 0);
+    CHECK_EQUAL(test_random<RobinHoodProbing>(), 0);
+    CHECK_EQUAL((test_random<PowerOfTwoCapacity, RobinHoodProbing>()), 0);
+    CHECK_EQUAL(test_random<IncrementalRehash<> >(), 0);
+    CHECK_EQUAL((test_random<RobinHoodProbing, IncrementalRehash<2> >()), 0);
+    CHECK_EQUAL(test_store_hash(), 0);
+    CHECK_EQUAL(test_collisions<StoreHash>(300), 0);
+    CHECK_EQUAL(test_random<StoreHash>(), 0);
+    CHECK_EQUAL((test_random<StoreHash, RobinHoodProbing, IncrementalRehash<> >()), 0);
+    CHECK_EQUAL(test_heterogeneous(), 0);
+    CHECK_EQUAL(test_find_many(), 0);
+    CHECK_EQUAL(test_split_key_value(), 0);
+    CHECK_EQUAL(test_random<SplitKeyValue>(), 0);
+    CHECK_EQUAL((test_random<SplitKeyValue, StoreHash, RobinHoodProbing, IncrementalRehash<> >()), 0);
+    CHECK_EQUAL(test_reserve(), 0);
+    CHECK_EQUAL(test_reserve<PowerOfTwoCapacity>(), 0);
+    CHECK_EQUAL((test_reserve<RobinHoodProbing, StoreHash>()), 0);
+    CHECK_EQUAL(test_reserve<IncrementalRehash<4> >(), 0);
+    CHECK_EQUAL(test_stats(), 0);
+    CHECK_EQUAL(test_stats<RobinHoodProbing>(), 0);
+    CHECK_EQUAL((test_stats<PowerOfTwoCapacity, StoreHash>()), 0);
+    CHECK_EQUAL(test_random<InlineStorage<32> >(), 0);
+    CHECK_EQUAL((test_random<InlineStorage<16>, PowerOfTwoCapacity, RobinHoodProbing>()), 0);
+    CHECK_EQUAL((test_random<InlineStorage<16>, SplitKeyValue, StoreHash, IncrementalRehash<> >()), 0);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <cpp.20/OpenHashMapView.hpp>
+#include <cpp.20/MappedFile.hpp>
+#include "../common/check.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+struct Record {
+    int a;
+    double b;
+};
+
+///view type matching the map
+template<typename K, typename V, typename Hash, typename Equal, typename ... Options>
+OpenHashMapView<K, V, Hash, Equal, Options...> make_view_type(const OpenHashMap<K, V, Hash, Equal, Options...> &);
+
+template<typename Map>
+std::vector<std::byte> write_image(Map &map) {
+    using View = decltype(make_view_type(map));
+    std::vector<std::byte> out;
+    View::write(map, [&](std::span<const std::byte> data) {
+        out.insert(out.end(), data.begin(), data.end());
+    });
+    return out;
+}
+
+template<typename ... Options>
+int test_image(int count) {
+    OpenHashMap<int, Record, std::hash<int>, std::equal_to<int>, Options...> map;
+    for (int i = 0; i < count; ++i) map.emplace(i * 3, Record{i, i * 0.5});
+    for (int i = 0; i < count; i += 7) map.erase(i * 3);
+    auto image = write_image(map);
+    using View = decltype(make_view_type(map));
+    if (image.size() != View::image_size(map)) return 1;
+    View view(image);
+    if (view.size() != map.size() || view.capacity() != map.capacity()) return 2;
+    for (int i = 0; i < count * 3; ++i) {
+        auto iter = view.find(i);
+        bool expected = i % 3 == 0 && (i / 3) % 7 != 0;
+        if ((iter != view.end()) != expected) return 3;
+        if (expected && (iter->second.a != i / 3 || iter->first != i)) return 4;
+    }
+    std::size_t cnt = 0;
+    for (const auto &[k, v]: view) {
+        if (map.find(k)->second.a != v.a) return 5;
+        ++cnt;
+    }
+    if (cnt != map.size()) return 6;
+    return 0;
+}
+
+int test_invalid() {
+    OpenHashMap<int, int> map;
+    map.emplace(1, 1);
+    auto image = write_image(map);
+    try {
+        OpenHashMapView<int, long long> view(image);
+        return 1;
+    } catch (const std::invalid_argument &) {}
+    try {
+        OpenHashMapView<int, int, std::hash<int>, std::equal_to<int>, PowerOfTwoCapacity> view(image);
+        return 2;
+    } catch (const std::invalid_argument &) {}
+    try {
+        OpenHashMapView<int, int> view(std::span<const std::byte>(image).first(image.size() - 1));
+        return 3;
+    } catch (const std::invalid_argument &) {}
+    {
+        //capacity, which overflows the sums of offsets and sizes
+        auto damaged = image;
+        damaged.resize(2048);
+        OpenHashMapImageHeader hdr;
+        std::memcpy(&hdr, damaged.data(), sizeof(hdr));
+        hdr.ctrl_offset = 128;
+        hdr.capacity = 0 - hdr.ctrl_offset - 16;
+        hdr.keys_offset = hdr.values_offset = 1024;
+        hdr.total_size = damaged.size();
+        std::memcpy(damaged.data(), &hdr, sizeof(hdr));
+        try {
+            OpenHashMapView<int, int> view(damaged);
+            return 6;
+        } catch (const std::invalid_argument &) {}
+    }
+    image[0] = std::byte{'X'};
+    try {
+        OpenHashMapView<int, int> view(image);
+        return 4;
+    } catch (const std::invalid_argument &) {}
+    OpenHashMap<int, int> empty;
+    auto empty_image = write_image(empty);
+    OpenHashMapView<int, int> empty_view(empty_image);
+    return empty_view.empty() && !empty_view.contains(1) && empty_view.begin() == empty_view.end()?0:5;
+}
+
+int test_mapped_file() {
+    OpenHashMap<std::uint64_t, std::uint64_t> map;
+    for (std::uint64_t i = 0; i < 10000; ++i) map.emplace(i * i, i);
+    auto path = std::filesystem::temp_directory_path() / "test_open_hash_map_view.bin";
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        OpenHashMapView<std::uint64_t, std::uint64_t>::write(map, [&](std::span<const std::byte> data) {
+            f.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        });
+    }
+    int r = 0;
+    {
+        MappedFile file(path);
+        OpenHashMapView<std::uint64_t, std::uint64_t> view(file.bytes());
+        for (std::uint64_t i = 0; i < 10000; ++i) {
+            if (view.at(i * i) != i) {r = 1; break;}
+        }
+        if (view.contains(3)) r = 2;
+    }
+    std::filesystem::remove(path);
+    return r;
+}
+
+int main() {
+    CHECK_EQUAL(test_image(1000), 0);
+    CHECK_EQUAL(test_image<PowerOfTwoCapacity>(1000), 0);
+    CHECK_EQUAL(test_image<RobinHoodProbing>(1000), 0);
+    CHECK_EQUAL((test_image<SplitKeyValue, StoreHash>(1000)), 0);
+    CHECK_EQUAL(test_image<IncrementalRehash<2> >(1000), 0);
+    CHECK_EQUAL(test_invalid(), 0);
+    CHECK_EQUAL(test_mapped_file(), 0);
+    CHECK_EXCEPTION(std::system_error, MappedFile("/nonexistent/file"));
+    return 0;
+}
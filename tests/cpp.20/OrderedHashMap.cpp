@@ -0,0 +1,125 @@
+#include <cpp.20/OrderedHashMap.hpp>
+#include "../common/check.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct PrimHash {
+    constexpr std::size_t operator()(int x) const {return static_cast<std::size_t>(x);}
+};
+
+struct ConstHash {
+    constexpr std::size_t operator()(int) const {return 1;}
+};
+
+template<typename Hash>
+constexpr int test_ordered() {
+    OrderedHashMap<int, int, Hash> hh;
+    //insert in descending order
+    for (int i = 100; i > 0; --i) hh.emplace(i, i * 2);
+    if (hh.size() != 100) return 1;
+    if (hh.emplace(50, 0).second || hh.find(50)->second != 100) return 2;
+    int expect = 100;
+    for (const auto &[k, v]: hh) {
+        if (k != expect || v != k * 2) return 3;
+        --expect;
+    }
+    //erase keeps order
+    for (int i = 1; i <= 100; i += 3) if (!hh.erase(i)) return 4;
+    if (hh.erase(1) || hh.contains(1)) return 5;
+    int prev = 101;
+    for (const auto &[k, v]: hh) {
+        if (k >= prev || k % 3 == 1 || hh.find(k)->second != k * 2) return 6;
+        prev = k;
+    }
+    //swap erase moves the last item
+    auto last = hh.nth(hh.size() - 1).first;
+    auto first = hh.nth(0).first;
+    if (!hh.swap_erase(first) || hh.nth(0).first != last) return 7;
+    for (int i = 1; i <= 100; ++i) {
+        bool present = i % 3 != 1 && i != first;
+        if (hh.contains(i) != present) return 8;
+    }
+    //erase by iterator
+    auto it = hh.begin();
+    while (it != hh.end()) it = hh.erase(it);
+    if (!hh.empty()) return 9;
+    hh[5] = 10;
+    return hh.find(5)->second == 10?0:10;
+}
+
+static_assert(test_ordered<PrimHash>() == 0, "Failed");
+static_assert(test_ordered<ConstHash>() == 0, "Failed");
+
+constexpr int test_reserve() {
+    OrderedHashMap<int, int, PrimHash> hh(1000);
+    auto idx = hh.index_size();
+    for (int i = 0; i < 1000; ++i) hh.emplace(i, i);
+    //no growth of the index after reserve
+    if (hh.index_size() != idx || idx > 2048) return 1;
+    auto cpy = hh;
+    hh.clear();
+    if (!hh.empty() || hh.contains(1) || cpy.size() != 1000 || !cpy.contains(999)) return 2;
+    return 0;
+}
+
+static_assert(test_reserve() == 0, "Failed");
+
+int test_strings() {
+    struct TransparentHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const {return std::hash<std::string_view>()(s);}
+    };
+    OrderedHashMap<std::string, int, TransparentHash, std::equal_to<> > hh;
+    hh.try_emplace(std::string_view("beta"), 2);
+    hh.try_emplace(std::string_view("alfa"), 1);
+    if (hh.nth(0).first != "beta" || hh.find(std::string_view("alfa"))->second != 1) return 1;
+    auto h = hh.hash_function()("gamma");
+    hh.try_emplace_hashed(h, std::string_view("gamma"), 3);
+    if (hh.find(std::string_view("gamma"), h)->second != 3) return 2;
+    if (!hh.erase(std::string_view("beta")) || hh.nth(0).first != "alfa") return 3;
+    return 0;
+}
+
+///random operations compared with std::unordered_map, order compared with vector
+int test_random() {
+    OrderedHashMap<int, int> hh;
+    std::unordered_map<int, int> ref;
+    std::vector<int> order;
+    std::mt19937 rnd(1);
+    for (int i = 0; i < 100000; ++i) {
+        int k = static_cast<int>(rnd() % 2000);
+        switch (rnd() % 3) {
+            case 0: if (hh.emplace(k, i).second != ref.emplace(k, i).second) return 1;
+                    if (std::find(order.begin(), order.end(), k) == order.end()) order.push_back(k);
+                    break;
+            case 1: if (hh.erase(k) != (ref.erase(k) != 0)) return 2;
+                    std::erase(order, k);
+                    break;
+            default: {
+                auto iter = hh.find(k);
+                auto riter = ref.find(k);
+                if ((iter == hh.end()) != (riter == ref.end())) return 3;
+                if (iter != hh.end() && iter->second != riter->second) return 4;
+            }
+        }
+        if (hh.size() != ref.size()) return 5;
+    }
+    std::size_t pos = 0;
+    for (const auto &[k, v]: hh) {
+        if (order[pos++] != k || ref.at(k) != v) return 6;
+    }
+    return 0;
+}
+
+int main() {
+    CHECK_EQUAL(test_ordered<PrimHash>(), 0);
+    CHECK_EQUAL(test_ordered<ConstHash>(), 0);
+    CHECK_EQUAL(test_reserve(), 0);
+    CHECK_EQUAL(test_strings(), 0);
+    CHECK_EQUAL(test_random(), 0);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <cpp.20/ShardedHashMap.hpp>
+#include "../common/check.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+int test_basic() {
+    ShardedHashMap<std::string, int> map(8);
+    if (map.shard_count() != 8) return 1;
+    if (!map.try_emplace("alfa", 1) || map.try_emplace("alfa", 2)) return 2;
+    if (!map.insert_or_assign(std::string("beta"), 2) || map.insert_or_assign(std::string("beta"), 3)) return 3;
+    if (map.get("alfa") != 1 || map.get("beta") != 3 || map.get("gamma").has_value()) return 4;
+    if (!map.update("alfa", [](int &v) {v += 10;}) || map.get("alfa") != 11) return 5;
+    if (map.update("gamma", [](int &) {})) return 6;
+    if (map.size() != 2 || !map.erase("alfa") || map.erase("alfa") || map.contains("alfa")) return 7;
+    int sum = 0;
+    map.for_each([&](const std::string &, int v) {sum += v;});
+    if (sum != 3) return 8;
+    map.clear();
+    return map.empty()?0:9;
+}
+
+int test_threads() {
+    constexpr int threads = 8;
+    constexpr int per_thread = 20000;
+    ShardedHashMap<int, int> map(16);
+    map.reserve(threads * per_thread);
+    std::atomic<int> errors = 0;
+    std::atomic<bool> done = false;
+    std::vector<std::thread> writers;
+    //readers check, that value matches the key, when it is found
+    std::thread reader([&]{
+        while (!done) {
+            for (int i = 0; i < threads * per_thread; i += 97) {
+                map.visit(i, [&](int v) {if (v != i * 2) ++errors;});
+            }
+        }
+    });
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&, t]{
+            for (int i = t * per_thread; i < (t + 1) * per_thread; ++i) {
+                if (!map.try_emplace(i, i * 2)) ++errors;
+            }
+            for (int i = t * per_thread; i < (t + 1) * per_thread; i += 2) {
+                if (!map.erase(i)) ++errors;
+            }
+        });
+    }
+    for (auto &w: writers) w.join();
+    done = true;
+    reader.join();
+    if (errors) return 1;
+    if (map.size() != threads * per_thread / 2) return 2;
+    for (int i = 0; i < threads * per_thread; ++i) {
+        if (map.contains(i) != (i % 2 == 1)) return 3;
+    }
+    return 0;
+}
+
+int main() {
+    CHECK_EQUAL(test_basic(), 0);
+    CHECK_EQUAL(test_threads(), 0);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <cpp.20/flatmap.hpp>
+#include "../common/check.hpp"
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+int test_try_emplace() {
+    FlatMap<int, int> fm;
+    for (int i = 10; i > 0; --i) if (!fm.try_emplace(i, i * 2).second) return 1;
+    for (int i = 11; i <= 20; ++i) if (!fm.try_emplace(i, i * 2).second) return 2;
+    auto r = fm.try_emplace(5, 0);
+    if (r.second || r.first->second != 10) return 3;
+    if (fm.size() != 20 || !std::is_sorted(fm.begin(), fm.end())) return 4;
+    return 0;
+}
+
+int test_insert_range() {
+    FlatMap<int, std::string> fm;
+    fm.try_emplace(5, "five");
+    std::vector<std::pair<int, std::string> > items = {{3, "a"}, {5, "b"}, {1, "c"}, {3, "d"}, {9, "e"}};
+    if (fm.insert_range(items) != 3) return 1;
+    if (fm.size() != 4) return 2;
+    if (fm.find(5)->second != "five" || fm.find(3)->second != "a") return 3;
+    if (items[0].second != "a") return 4;
+    if (fm.insert_range(std::move(items)) != 0) return 5;
+    FlatMap<int, std::string> other;
+    other.try_emplace(2, "x");
+    other.try_emplace(5, "y");
+    if (fm.merge(other) != 1 || other.size() != 2) return 6;
+    if (fm.merge(std::move(other)) != 0 || !other.empty()) return 7;
+    int prev = 0;
+    for (const auto &[k, v]: fm) {
+        if (k <= prev) return 8;
+        prev = k;
+    }
+    return 0;
+}
+
+int test_builder() {
+    FlatMap<std::string, int> fm;
+    fm.try_emplace("b", 0);
+    fm.append("d", 1);
+    fm.append("a", 2);
+    fm.append("b", 3);
+    fm.append("c", 4);
+    fm.append("a", 5);
+    //lookup sorts the map
+    if (fm.find(std::string_view("a"))->second != 2) return 1;
+    if (fm.size() != 4 || fm.find(std::string_view("b"))->second != 0) return 2;
+    fm.append("e", 6);
+    if (fm.commit() != 0 || fm.back().first != "e") return 3;
+    const auto &cfm = fm;
+    fm.append("0", 7);
+    fm.append("b", 8);
+    //const lookup doesn't sort the map, the first occurrence wins
+    if (cfm.find(std::string_view("0"))->second != 7 || cfm.begin()->first == "0") return 4;
+    if (cfm.find(std::string_view("b"))->second != 0 || cfm.find(std::string_view("x")) != cfm.end()) return 5;
+    try {
+        cfm.lower_bound(std::string_view("0"));
+        return 6;
+    } catch (const std::logic_error &) {
+    }
+    if (fm.lower_bound(std::string_view("0"))->second != 7 || cfm.begin()->first != "0") return 7;
+    return 0;
+}
+
+///copy and move of map with appended items
+int test_copy() {
+    FlatMap<int, int> a;
+    a.try_emplace(1, 1);
+    a.append(3, 3);
+    a.append(2, 2);
+    a.append(3, 4);
+    FlatMap<int, int> b = a;
+    if (b.commit() != 1 || b.size() != 3 || b.find(3)->second != 3) return 1;
+    const FlatMap<int, int> &ca = a;
+    FlatMap<int, int> c = ca;
+    if (c.commit() != 1 || c.size() != 3) return 2;
+    FlatMap<int, int> d = std::move(a);
+    if (d.commit() != 1 || d.size() != 3 || d.begin()->first != 1) return 3;
+    FlatMap<int, int> e;
+    e.append(5, 5);
+    e.append(4, 4);
+    if (b.merge(std::as_const(e)) != 2 || b.size() != 5 || e.begin()->first != 5) return 4;
+    e = b;
+    e.freeze();
+    FlatMap<int, int> f = e;
+    if (!f.is_frozen() || f.find(4)->second != 4) return 5;
+    return 0;
+}
+
+///random bulk loads compared with std::map
+int test_random() {
+    std::mt19937 rnd(1);
+    FlatMap<int, int> fm;
+    std::map<int, int> ref;
+    for (int round = 0; round < 20; ++round) {
+        std::vector<std::pair<int, int> > items;
+        for (int i = 0; i < 1000; ++i) items.emplace_back(static_cast<int>(rnd() % 10000), round);
+        auto inserted = fm.insert_range(items);
+        std::size_t ref_inserted = 0;
+        for (const auto &x: items) ref_inserted += ref.insert(x).second;
+        if (inserted != ref_inserted) return 1;
+    }
+    if (fm.size() != ref.size()) return 2;
+    if (!std::equal(fm.begin(), fm.end(), ref.begin(), ref.end(), [](const auto &a, const auto &b) {
+        return a.first == b.first && a.second == b.second;
+    })) return 3;
+    return 0;
+}
+
+///lookups with search index compared with binary search
+int test_freeze() {
+    for (std::size_t n: {0, 1, 2, 3, 7, 8, 100, 1000, 1023, 1024, 1025}) {
+        FlatMap<int, int> fm;
+        for (std::size_t i = 0; i < n; ++i) fm.append(static_cast<int>(i * 2), static_cast<int>(i));
+        fm.commit();
+        FlatMap<int, int> ref = fm;
+        fm.freeze();
+        if (!fm.is_frozen() || ref.is_frozen()) return 1;
+        for (int x = -1; x <= static_cast<int>(n * 2); ++x) {
+            if (fm.lower_bound(x) - fm.begin() != ref.lower_bound(x) - ref.begin()) return 2;
+            if (fm.upper_bound(x) - fm.begin() != ref.upper_bound(x) - ref.begin()) return 3;
+            auto iter = fm.find(x);
+            if ((iter == fm.end()) != (x < 0 || (x & 1) || x >= static_cast<int>(n * 2))) return 4;
+        }
+    }
+    FlatMap<std::string, int> sm;
+    for (int i = 0; i < 100; ++i) sm.try_emplace(std::to_string(i), i);
+    sm.freeze();
+    if (sm.find(std::string_view("42"))->second != 42 || sm.find(std::string_view("x")) != sm.end()) return 5;
+    sm.try_emplace("x", 1);
+    if (sm.is_frozen() || sm.find(std::string_view("x"))->second != 1) return 6;
+    sm.freeze();
+    sm.erase(std::string_view("x"));
+    if (sm.is_frozen() || sm.find(std::string_view("x")) != sm.end()) return 7;
+    return 0;
+}
+
+///small maps are searched by scan of tags
+int test_small_scan() {
+    std::mt19937 rnd(2);
+    for (int round = 0; round < 200; ++round) {
+        FlatMap<std::string, int> fm;
+        std::map<std::string, int> ref;
+        for (int i = 0; i < 40; ++i) {
+            auto k = std::to_string(rnd() % 30);
+            bool changed;
+            if (rnd() % 3 == 0) {
+                changed = ref.erase(k) != 0;
+                fm.erase(std::string_view(k));
+                if (fm.size() != ref.size()) return 1;
+            } else {
+                int v = static_cast<int>(rnd());
+                changed = ref.emplace(k, v).second;
+                if (fm.try_emplace(k, v).second != changed) return 2;
+            }
+            if (changed && fm.is_frozen()) return 8;
+            fm.freeze();
+            if (!fm.is_frozen()) return 9;
+            for (int j = 0; j < 30; ++j) {
+                auto q = std::to_string(j);
+                auto iter = fm.find(q);
+                auto riter = ref.find(q);
+                if ((iter == fm.end()) != (riter == ref.end())) return 3;
+                if (iter != fm.end() && iter->second != riter->second) return 4;
+                if (fm.find(std::string_view(q)) != iter || fm.find(q.c_str()) != iter) return 5;
+            }
+        }
+    }
+    //unsigned keys and signed lookup
+    FlatMap<unsigned int, int> um;
+    um.try_emplace(0xFFFFFFFFU, 1);
+    um.try_emplace(5U, 2);
+    um.freeze();
+    if (um.find(-1) == um.end() || um.find(5)->second != 2 || um.find(6) != um.end()) return 6;
+    //swap exchanges tags
+    FlatMap<int, int> a, b;
+    for (int i = 0; i < 3; ++i) {
+        a.try_emplace(i, i);
+        b.try_emplace(i + 10, i);
+    }
+    a.freeze();
+    b.freeze();
+    a.swap(b);
+    if (a.find(10) == a.end() || a.find(0) != a.end() || b.find(0) == b.end()) return 7;
+    //key modified through iterator, then frozen again
+    a.begin()->first = 9;
+    a.freeze();
+    if (a.find(9) == a.end() || a.find(10) != a.end()) return 10;
+    //pointer keys are ordered by address, no tags
+    static const char *const names[] = {"b", "a"};
+    FlatMap<const char *, int> pm;
+    pm.try_emplace(names[0], 1);
+    pm.try_emplace(names[1], 2);
+    pm.freeze();
+    if (pm.find(names[1])->second != 2 || pm.find(static_cast<const char *>(nullptr)) != pm.end()) return 11;
+    return 0;
+}
+
+int main() {
+    CHECK_EQUAL(test_try_emplace(), 0);
+    CHECK_EQUAL(test_insert_range(), 0);
+    CHECK_EQUAL(test_builder(), 0);
+    CHECK_EQUAL(test_copy(), 0);
+    CHECK_EQUAL(test_random(), 0);
+    CHECK_EQUAL(test_freeze(), 0);
+    CHECK_EQUAL(test_small_scan(), 0);
+}
@@ -1,6 +1,357 @@
 #include "../../src/cpp.20/json.hpp"
+#include "../common/check.hpp"
+#include <memory_resource>
+#include <string>
+#include <thread>
 
+static Json parse_text(std::string_view text, bool intern_keys = false) {
+    std::size_t pos = 0;
+    return Json::parse([&]() -> std::optional<char> {
+        if (pos < text.size()) return text[pos++];
+        return {};
+    }, intern_keys);
+}
+
+static std::string to_string(const Json &j) {
+    std::string out;
+    j.serialize([&](char c) {out.push_back(c);});
+    return out;
+}
+
+int test_parse() {
+    auto j = parse_text(R"({"b":1,"a":[true,null,"x\ny"],"c":{"z":2,"y":-3.5}})");
+    if (to_string(j) != R"({"a":[true,null,"x\ny"],"b":1,"c":{"y":-3.5,"z":2}})") return 1;
+    if (j["c"]["y"].as_double() != -3.5 || j["a"][2].as_text() != "x\ny") return 2;
+    if (!j["missing"].is_null()) return 3;
+    Json obj;
+    obj.set("x", JsonNumber(1));
+    obj.set("y", Json("text"));
+    if (to_string(obj) != R"({"x":1,"y":"text"})") return 4;
+    //small parsed objects are frozen (tag scan), modification unfreezes
+    if (!j.as_object().is_frozen() || !j["c"].as_object().is_frozen()) return 5;
+    if (!Json::parse_indexed(R"({"k":1})").as_object().is_frozen()) return 6;
+    if (!Json(j, JsonAllocator()).as_object().is_frozen()) return 7;
+    j.set("d", Json(nullptr));
+    if (j.as_object().is_frozen() || !j["c"].as_object().is_frozen() || !j["d"].is_null()) return 8;
+    return 0;
+}
+
+int test_interned_keys() {
+    auto &pool = JsonKeyPool::global();
+    auto a = parse_text(R"({"name":"a","value":1,"tags":{"name":"x"}})", true);
+    auto cnt = pool.size();
+    auto b = parse_text(R"({"value":2,"name":"b"})", true);
+    if (pool.size() != cnt) return 1;
+    auto ka = a.as_object().find(std::string_view("name"))->first;
+    auto kb = b.as_object().find(std::string_view("name"))->first;
+    if (!ka.is_interned() || ka.view().data() != kb.view().data()) return 2;
+    if (ka.view().data() != a["tags"].as_object().begin()->first.view().data()) return 3;
+    if (b["name"].as_text() != "b" || b[Json::key("value")].as_int() != 2) return 4;
+    if (Json::key("name") != ka || Json::key("name") == Json::key("value")) return 5;
+    if (JsonKey(std::string("name")) != ka) return 6;
+    //other pool interns the same text as a different string
+    JsonKeyPool other;
+    auto ko = other.intern("name");
+    if (ko != ka || (ko <=> ka) != 0 || ko == other.intern("value")) return 9;
+    auto c = parse_text(R"({"name":"c"})");
+    if (c.as_object().begin()->first.is_interned()) return 7;
+    //same content
+    if (to_string(a) != R"({"name":"a","tags":{"name":"x"},"value":1})") return 8;
+    return 0;
+}
+
+int test_concurrent_interning() {
+    std::vector<std::thread> thr;
+    std::vector<std::vector<const char *> > ptrs(4);
+    for (std::size_t t = 0; t < 4; ++t) {
+        thr.emplace_back([&, t]{
+            for (int i = 0; i < 1000; ++i) {
+                ptrs[t].push_back(Json::key("k" + std::to_string(i)).view().data());
+            }
+        });
+    }
+    for (auto &t: thr) t.join();
+    for (std::size_t t = 1; t < 4; ++t) if (ptrs[t] != ptrs[0]) return 1;
+    return 0;
+}
+
+int test_parse_buffer() {
+    const char *docs[] = {
+        R"({"b":1,"a":[true,null,"x\ny"],"c":{"z":2,"y":-3.5e+2}})",
+        R"(  [ 1 , 2.25 , "a\"b\\c" , { } , [ ] , false ]  )",
+        R"("plain")",
+        R"(0)",
+        R"({"k":{"k":{"k":[[[]]]}}})",
+    };
+    for (auto d: docs) {
+        auto a = Json::parse(std::string_view(d));
+        auto b = parse_text(d);
+        if (to_string(a) != to_string(b)) return 1;
+    }
+    //numbers keep their text
+    if (to_string(Json::parse(std::string_view("[1.50,12345678901234567890]"))) != "[1.50,12345678901234567890]") return 2;
+    //escapes
+    auto s = Json::parse(std::string_view(R"("\u00e9\u20ac\ud83d\ude00\t\/\b")"));
+    if (s.as_text() != "\u00e9\u20ac\U0001F600\t/\b") return 3;
+    //utf-8 is copied
+    if (Json::parse(std::string_view("\"\u017elu\u0165ou\u010dk\u00fd\"")).as_text() != "\u017elu\u0165ou\u010dk\u00fd") return 4;
+    const char *bad[] = {"", "[1,", "{\"a\":1,\"a\":2}", "tru", "[1 2]", "{\"a\" 1}", "\"abc", "01", "1 x", "{1:2}", "-",
+                         "\"\\x\"", "\"\\uD800\"", "\"\\uDC00\"", "\"\\uD800\\u0041\"", "\"\\uD800\\n\""};
+    for (auto d: bad) {
+        try {
+            Json::parse(std::string_view(d));
+            return 5;
+        } catch (const Json::ParseError &) {}
+    }
+    std::string txt = R"({"name":"x","id":5})";
+    auto j = Json::parse(std::as_bytes(std::span(txt)), true);
+    if (j["id"].as_int() != 5 || !j.as_object().begin()->first.is_interned()) return 6;
+    return 0;
+}
+
+int test_parse_indexed() {
+    std::string long_text(100, 'x');
+    std::string docs[] = {
+        R"({"b":1,"a":[true,null,"x\ny"],"c":{"z":2,"y":-3.5e+2}})",
+        R"(  [ 1 , 2.25 , "a\"b\\c" , { } , [ ] , false ]  )",
+        R"("plain")",
+        R"(0)",
+        "\t[null]\n",
+        R"({"k":{"k":{"k":[[[]]]}}})",
+        R"({"long":")" + long_text + R"(","after":[1,2]})",
+        //string with structural characters and escaped quotes
+        R"(["{[,:]}",  "\"}\\",  "\\\"",  123])",
+    };
+    for (const auto &d: docs) {
+        if (to_string(Json::parse_indexed(d)) != to_string(Json::parse(d))) return 1;
+    }
+    //escape sequences and quotes at every offset around block boundary
+    for (std::size_t pad = 55; pad < 70; ++pad) {
+        for (const char *tail: {R"(\\")", R"(\"")", R"(\\\"")", R"(")"}) {
+            std::string d = "[" + std::string(pad, ' ') + "\"" + std::string(pad / 4, 'a') + tail + ",1]";
+            if (to_string(Json::parse_indexed(d)) != to_string(Json::parse(d))) return 2;
+        }
+        std::string d = "[" + std::string(pad, ' ') + "123456789,true]";
+        if (to_string(Json::parse_indexed(d)) != "[123456789,true]") return 3;
+    }
+    const char *bad[] = {"", "[1,", "{\"a\":1,\"a\":2}", "tru", "[1 2]", "{\"a\" 1}", "\"abc", "01", "1 x",
+                         "{1:2}", "-", "[\"a\"1]", "[1]]", "{\"a\":}", "[,1]", "\"a\\\"",
+                         "\"\\x\"", "\"\\uD800\"", "\"\\uDC00\"", "\"\\uD800\\u0041\"", "{\"\\q\":1}"};
+    for (auto d: bad) {
+        try {
+            Json::parse_indexed(std::string_view(d));
+            return 4;
+        } catch (const Json::ParseError &) {}
+    }
+    std::string txt = R"({"name":"x","id":5})";
+    auto j = Json::parse_indexed(std::as_bytes(std::span(txt)), true);
+    if (j["id"].as_int() != 5 || !j.as_object().begin()->first.is_interned()) return 5;
+    return 0;
+}
+
+int test_view() {
+    std::string doc = R"( {"skip":[{"a":"]}\"[{"},[1,2,[3]],"\\"],"id":42,"name":"caf\u00e9",)"
+                      R"("esc\"key":true,"list":[1.5,null,"x",{"k":false}],"empty":{},"neg":-7} )";
+    JsonView v(doc);
+    if (!v.is_object() || v.size() != 7) return 1;
+    if (v["id"].as_int() != 42 || v["name"].as_text() != "caf\u00e9") return 2;
+    if (!v["esc\"key"].as_bool() || v["neg"].as_long() != -7) return 3;
+    if (!v["missing"].is_null() || !v["id"]["x"].is_null() || !v["list"][10].is_null()) return 4;
+    auto list = v["list"];
+    if (!list.is_array() || list.size() != 4 || list[0].as_double() != 1.5) return 5;
+    if (!list[1].is_null() || list[2].as_text() != "x" || list[3]["k"].as_bool() || !list[3]["k"].is_bool()) return 6;
+    if (v["empty"].size() != 0 || !v["empty"].as_object().empty() || !v["list"].as_object().empty()) return 7;
+    if (v["skip"].raw() != R"([{"a":"]}\"[{"},[1,2,[3]],"\\"])") return 8;
+    std::string keys;
+    for (const auto &[k, val]: v.as_object()) keys.append(k).push_back(val.is_string()?'s':'.');
+    if (keys != "skip.id.names" "esc\"key.list.empty.neg.") return 9;
+    std::string items;
+    for (auto x: list.as_array()) items.append(x.raw());
+    if (items != R"(1.5null"x"{"k":false})") return 10;
+    //conversion to Json
+    if (to_string(v["skip"].to_json()) != to_string(Json::parse(v["skip"].raw()))) return 11;
+    if (to_string(v.to_json()) != to_string(Json::parse(doc))) return 12;
+    if (v["list"].as_int() != 0 || v["id"].as_number() != "42") return 13;
+    if (!JsonView().is_null() || !JsonView("  ").is_null()) return 14;
+    if (JsonView(std::as_bytes(std::span(doc)))["id"].as_int() != 42) return 15;
+    //untouched parts are not validated, accessed parts are
+    JsonView bad(R"({"a":1,"b":[1,2 3],"c":)");
+    if (bad["a"].as_int() != 1) return 16;
+    try {
+        bad["c"].as_int();
+        return 17;
+    } catch (const Json::ParseError &) {}
+    try {
+        bad["b"].size();
+        return 18;
+    } catch (const Json::ParseError &) {}
+    return 0;
+}
+
+///Memory resource, which counts allocations
+class CountingResource: public std::pmr::memory_resource {
+public:
+    std::size_t allocations = 0;
+    std::size_t allocated = 0;
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        allocated += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+int test_arena() {
+    std::string long_text(100, 'x');
+    std::string text = R"({"b":1,"a":[true,null,"x\ny",")" + long_text + R"("],"c":{"z":2,"y":-3.5,")" + long_text + R"(":{}}})";
+    CountingResource def;
+    CountingResource upstream;
+    auto prev = std::pmr::set_default_resource(&def);
+    {
+        auto doc = JsonDocument::parse(text, false, &upstream);
+        //everything is in the arena, which is allocated by few large blocks
+        if (def.allocations != 0 || upstream.allocations > 3) return 1;
+        if (to_string(doc.root()) != to_string(Json::parse(text))) return 2;
+        if (doc["a"][3].as_text() != long_text || doc["c"]["y"].as_double() != -3.5) return 3;
+        std::size_t cnt = def.allocations;
+        std::size_t ucnt = upstream.allocations;
+        //copy is allocated by default resource
+        Json copy = doc.root();
+        if (def.allocations == cnt || to_string(copy) != to_string(doc.root())) return 4;
+        //copy into other document
+        JsonDocument doc2(copy, &upstream);
+        if (upstream.allocations == ucnt || to_string(doc2.root()) != to_string(copy)) return 5;
+        JsonDocument doc3 = std::move(doc2);
+        if (to_string(doc3.root()) != to_string(copy)) return 6;
+        std::size_t pos = 0;
+        auto doc4 = JsonDocument::parse([&]() -> std::optional<char> {
+            if (pos < text.size()) return text[pos++];
+            return {};
+        }, false, &upstream);
+        if (to_string(doc4.root()) != to_string(copy)) return 7;
+    }
+    if (upstream.allocated != 0 || def.allocated != 0) return 8;
+    //parse into monotonic resource, normal destruction
+    {
+        std::pmr::monotonic_buffer_resource mr(&upstream);
+        {
+            auto j = Json::parse_indexed(text, true, &mr);
+            auto k = Json::parse(text, false, &mr);
+            if (to_string(j) != to_string(k)) return 9;
+        }
+    }
+    std::pmr::set_default_resource(prev);
+    if (def.allocated != 0 || upstream.allocated != 0) return 10;
+    try {
+        JsonDocument::parse(std::string_view("[1,2"), false, &upstream);
+        return 11;
+    } catch (const Json::ParseError &) {}
+    if (upstream.allocated != 0) return 12;
+    return 0;
+}
+
+///Handler, which records events as text
+struct RecordingHandler {
+    std::string out;
+    void start_object() {out.append("{");}
+    void end_object() {out.append("}");}
+    void start_array() {out.append("[");}
+    void end_array() {out.append("]");}
+    void key(std::string_view s) {out.append("k:").append(s).append(";");}
+    void string(std::string_view s) {out.append("s:").append(s).append(";");}
+    void number(std::string_view s) {out.append("n:").append(s).append(";");}
+    void boolean(bool b) {out.append(b?"t;":"f;");}
+    void null() {out.append("0;");}
+};
+
+static std::string sax_parse(std::string_view text, std::size_t chunk) {
+    JsonSaxParser<RecordingHandler> parser;
+    for (std::size_t pos = 0; pos < text.size(); pos += chunk) {
+        auto part = text.substr(pos, chunk);
+        auto n = parser.feed(part);
+        if (n != part.size() && text.find_first_not_of(" \n", pos + n) != text.npos) throw Json::ParseError();
+    }
+    parser.finish();
+    return parser.handler().out;
+}
+
+int test_sax() {
+    const char *docs[] = {
+        R"({"b":1,"a":[true,null,"x\ny"],"c":{"z":2,"y":-3.5e+2}})",
+        R"(  [ 1 , 2.25 , "a\"b\\c" , { } , [ ] , false ]  )",
+        R"("plain")",
+        R"(12345)",
+        R"("\u00e9\u20ac\ud83d\ude00\t\/\b")",
+        R"({"long key with spaces":"long string value","k":[[[-0.5e-3]]]})",
+    };
+    const char *expected[] = {
+        "{k:b;n:1;k:a;[t;0;s:x\ny;]k:c;{k:z;n:2;k:y;n:-3.5e+2;}}",
+        "[n:1;n:2.25;s:a\"b\\c;{}[]f;]",
+        "s:plain;",
+        "n:12345;",
+        "s:\u00e9\u20ac\U0001F600\t/\b;",
+        "{k:long key with spaces;s:long string value;k:k;[[[n:-0.5e-3;]]]}",
+    };
+    for (std::size_t i = 0; i < std::size(docs); ++i) {
+        std::string_view d = docs[i];
+        for (std::size_t chunk = 1; chunk <= d.size(); ++chunk) {
+            if (sax_parse(d, chunk) != expected[i]) return 1;
+        }
+        //split at every position
+        for (std::size_t pos = 0; pos <= d.size(); ++pos) {
+            JsonSaxParser<RecordingHandler> parser;
+            parser.feed(d.substr(0, pos));
+            parser.feed(d.substr(pos));
+            parser.finish();
+            if (parser.handler().out != expected[i]) return 2;
+        }
+    }
+    //stream of documents
+    std::string_view stream = R"({"a":1} [2]"x" 3)";
+    JsonSaxParser<RecordingHandler> parser;
+    std::size_t docs_cnt = 0;
+    while (!stream.empty()) {
+        auto n = parser.feed(stream);
+        stream = stream.substr(n);
+        if (parser.done()) {
+            ++docs_cnt;
+            parser.reset();
+        }
+    }
+    parser.finish();
+    if (++docs_cnt != 4 || parser.handler().out != "{k:a;n:1;}[n:2;]s:x;n:3;") return 3;
+    //state is kept between chunks
+    JsonSaxParser<RecordingHandler> p2;
+    p2.feed(R"({"a":[{"b":)");
+    if (p2.done() || p2.depth() != 3) return 4;
+    p2.feed("1}]}");
+    if (!p2.done() || p2.depth() != 0) return 5;
+    const char *bad[] = {"", "[1,", "tru", "[1 2]", "{\"a\" 1}", "\"abc", "01", "{1:2}", "-", "[1}", "]", "{\"a\":1,}",
+                         "\"\\uzzzz\"", "nul1", "\"\\x\"", "\"\\uD800\"", "\"\\uDC00\"", "\"\\uD800\\u0041\"",
+                         "\"\\uD800x\"", "{\"\\q\":1}"};
+    for (auto d: bad) {
+        try {
+            sax_parse(d, 1);
+            return 6;
+        } catch (const Json::ParseError &) {}
+    }
+    return 0;
+}
 
 int main() {
-    
+    CHECK_EQUAL(test_parse(), 0);
+    CHECK_EQUAL(test_interned_keys(), 0);
+    CHECK_EQUAL(test_concurrent_interning(), 0);
+    CHECK_EQUAL(test_parse_buffer(), 0);
+    CHECK_EQUAL(test_parse_indexed(), 0);
+    CHECK_EQUAL(test_view(), 0);
+    CHECK_EQUAL(test_arena(), 0);
+    CHECK_EQUAL(test_sax(), 0);
 }